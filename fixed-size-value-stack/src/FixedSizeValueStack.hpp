@@ -7,6 +7,7 @@
 
 #include <cassert>
 #include <functional>
+#include <utility>
 
     template<class T>
     class FixedSizeValueStack {
@@ -29,6 +30,13 @@
             reset();
         }
 
+        FixedSizeValueStack(FixedSizeValueStack<T>&& other) noexcept :
+                array(other.array), begin(other.begin), capacity(other.capacity), initializer(std::move(other.initializer)) {
+            other.array = nullptr;
+            other.begin = 0;
+            other.capacity = 0;
+        }
+
         virtual ~FixedSizeValueStack() {
             delete [] array;
         }
@@ -36,7 +44,8 @@
         FixedSizeValueStack<T>&operator=(const FixedSizeValueStack<T>& other) {
             assert(capacity == other.capacity);
 
-            for(int i = 0; i < capacity; i++){
+            // items below begin are never read before being pushed again
+            for(int i = other.begin; i < capacity; i++){
                 array[i] = other.array[i];
             }
             begin = other.begin;
@@ -44,6 +53,30 @@
             return *this;
         }
 
+        FixedSizeValueStack<T>&operator=(FixedSizeValueStack<T>&& other) noexcept {
+            std::swap(array, other.array);
+            std::swap(begin, other.begin);
+            std::swap(capacity, other.capacity);
+            std::swap(initializer, other.initializer);
+            return *this;
+        }
+
+        /**
+         * Copy the content of a stack having the same capacity, assuming that the given number of items at the
+         * bottom of the two stacks are identical.
+         * @param other stack
+         * @param shared_size number of bottom items known to be identical
+         */
+        void copy_from(const FixedSizeValueStack<T>& other, int shared_size) {
+            assert(capacity == other.capacity);
+            assert(shared_size >= 0 && shared_size <= capacity);
+
+            for(int i = other.begin; i < capacity - shared_size; i++){
+                array[i] = other.array[i];
+            }
+            begin = other.begin;
+        }
+
         T get(){
             assert(begin < capacity);
             auto item = array[begin];
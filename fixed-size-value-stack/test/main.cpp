@@ -80,6 +80,30 @@ namespace {
 
     }
 
+    TEST_F(UtilsTests, Move) {
+
+        const auto dim = 10;
+        const auto initializer = [](int index) { return index + 1; };
+
+        FixedSizeValueStack<int> stack(dim, initializer);
+        stack.get();
+        stack.get();
+
+        FixedSizeValueStack<int> moved(std::move(stack));
+        ASSERT_EQ(moved.size(), dim - 2);
+        ASSERT_EQ(moved.get(), 3);
+
+        FixedSizeValueStack<int> other(dim, initializer);
+        other = std::move(moved);
+        ASSERT_EQ(other.size(), dim - 3);
+        ASSERT_EQ(other.get(), 4);
+
+        // the moved-from stack holds the previous content of the destination
+        ASSERT_EQ(moved.size(), dim);
+        ASSERT_EQ(moved.get(), 1);
+
+    }
+
 
 
 }
\ No newline at end of file
@@ -2,3 +2,127 @@
 // Created by acco on 5/25/18.
 //
 
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "mm.hpp"
+
+namespace mm {
+
+    namespace {
+
+        // stored in the cache line preceding each aligned block
+        struct AlignedBlockHeader {
+            void *base;
+            size_t mapped_size;
+        };
+
+        static_assert(sizeof(AlignedBlockHeader) <= CACHE_LINE_SIZE, "the header must fit in a cache line");
+
+        inline size_t round_up(size_t value, size_t multiple) {
+            return (value + multiple - 1) / multiple * multiple;
+        }
+
+        void *map_anonymous(size_t size, int flags) {
+            return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+        }
+
+        // the system call is used directly to avoid depending on libnuma
+        void apply_numa_policy(void *address, size_t size, NumaPolicy policy) {
+#ifdef SYS_mbind
+            if(policy == NumaPolicy::Interleave) {
+                // MPOL_INTERLEAVE, the kernel restricts the mask to the nodes the process is allowed to use
+                constexpr auto interleave_mode = 3;
+                const auto nodes_mask = ~0ul;
+                // best effort, the default placement is kept when the policy cannot be applied
+                syscall(SYS_mbind, address, size, interleave_mode, &nodes_mask, sizeof(nodes_mask) * 8 + 1, 0);
+            }
+#else
+            (void) address;
+            (void) size;
+            (void) policy;
+#endif
+        }
+
+    }
+
+    void *request_aligned_bytes(const size_t bytes, const AllocationOptions &options) {
+
+        auto header = AlignedBlockHeader{nullptr, 0};
+        char *data = nullptr;
+
+        if(bytes >= HUGE_PAGE_SIZE) {
+
+            if(options.page_size == PageSize::Huge) {
+                header.mapped_size = round_up(bytes + CACHE_LINE_SIZE, HUGE_PAGE_SIZE);
+                header.base = map_anonymous(header.mapped_size, MAP_HUGETLB);
+                if(header.base != MAP_FAILED) {
+                    data = static_cast<char *>(header.base) + CACHE_LINE_SIZE;
+                    apply_numa_policy(header.base, header.mapped_size, options.numa_policy);
+                }
+            }
+
+            if(!data) {
+
+                // with transparent huge pages the data is placed on a huge page boundary, so that all of its
+                // 2 MB ranges can be promoted
+                const auto transparent = options.page_size != PageSize::Default;
+                const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+                header.mapped_size = round_up(bytes + CACHE_LINE_SIZE + (transparent ? HUGE_PAGE_SIZE : 0), page_size);
+                header.base = map_anonymous(header.mapped_size, 0);
+                if(header.base == MAP_FAILED) {
+                    std::cerr << "mm::request_aligned_bytes error: mmap failed\n";
+                    abort();
+                }
+
+                // the policy must be set before the pages are touched for the first time
+                apply_numa_policy(header.base, header.mapped_size, options.numa_policy);
+
+                data = static_cast<char *>(header.base) + CACHE_LINE_SIZE;
+                if(transparent) {
+                    const auto address = reinterpret_cast<uintptr_t>(data);
+                    data += round_up(address, HUGE_PAGE_SIZE) - address;
+                    madvise(data, bytes, MADV_HUGEPAGE);
+                }
+
+            }
+
+        } else {
+
+            if(posix_memalign(&header.base, CACHE_LINE_SIZE, bytes + CACHE_LINE_SIZE) != 0) {
+                std::cerr << "mm::request_aligned_bytes error: posix_memalign failed\n";
+                abort();
+            }
+
+            data = static_cast<char *>(header.base) + CACHE_LINE_SIZE;
+            if(options.zeroed) {
+                memset(data, 0, bytes);
+            }
+
+        }
+
+        memcpy(data - CACHE_LINE_SIZE, &header, sizeof(header));
+
+        return data;
+
+    }
+
+    void release_aligned_bytes(void *ptr) {
+
+        if(!ptr) {
+            return;
+        }
+
+        auto header = AlignedBlockHeader();
+        memcpy(&header, static_cast<char *>(ptr) - CACHE_LINE_SIZE, sizeof(header));
+
+        if(header.mapped_size > 0) {
+            munmap(header.base, header.mapped_size);
+        } else {
+            free(header.base);
+        }
+
+    }
+
+}
@@ -65,6 +65,87 @@ namespace mm {
         ptr = nullptr;
     }
 
+    /*
+    * Alignment of the blocks returned by request_aligned_memory, i.e. the size of a cache line.
+    */
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    /*
+    * Size of a huge page. Blocks at least as large are obtained directly from the kernel, hence they are
+    * lazily zeroed on first touch and never cleared explicitly.
+    */
+    constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /*
+    * Pages backing an aligned block. Huge pages only apply to blocks of at least HUGE_PAGE_SIZE bytes.
+    */
+    enum class PageSize {
+        // regular pages
+        Default,
+        // transparent huge pages requested with madvise, used when the kernel has them enabled
+        TransparentHuge,
+        // huge pages reserved by the system (MAP_HUGETLB), falling back to TransparentHuge when none is available
+        Huge
+    };
+
+    /*
+    * Placement of the pages of an aligned block on the NUMA nodes. Policies only apply to blocks of at least
+    * HUGE_PAGE_SIZE bytes and are ignored on systems without NUMA support.
+    */
+    enum class NumaPolicy {
+        // pages are placed on the node of the thread touching them first
+        Default,
+        // pages are spread round-robin over all the nodes, so that threads running on any node share the bandwidth
+        // of all the memory controllers instead of contending for the one of the node that filled the block
+        Interleave
+    };
+
+    /*
+    * Settings of an aligned allocation.
+    */
+    struct AllocationOptions {
+        PageSize page_size = PageSize::Default;
+        NumaPolicy numa_policy = NumaPolicy::Default;
+        // whether small blocks are cleared, large ones always come zeroed from the kernel
+        bool zeroed = true;
+    };
+
+    /*
+    * Allocates a block of bytes aligned to CACHE_LINE_SIZE, aborting on failure.
+    * It must be released with release_aligned_bytes.
+    */
+    void *request_aligned_bytes(size_t bytes, const AllocationOptions &options = AllocationOptions());
+
+    /*
+    * Releases a block returned by request_aligned_bytes, null pointers are ignored.
+    */
+    void release_aligned_bytes(void *ptr);
+
+    /*
+    * Declare an array of primitive data types aligned to CACHE_LINE_SIZE, see request_aligned_bytes.
+    */
+    template<class T>
+    static inline T *request_aligned_memory(const size_t elements, const AllocationOptions &options = AllocationOptions()) {
+        return static_cast<T *>(request_aligned_bytes(elements * sizeof(T), options));
+    }
+
+    template<class T>
+    static inline void release_aligned_memory(T *&ptr) {
+        release_aligned_bytes(ptr);
+        ptr = nullptr;
+    }
+
+    /*
+    * Returns the number of elements of a row holding columns elements padded to a multiple of CACHE_LINE_SIZE bytes,
+    * so that each row of a matrix in an aligned block starts on its own cache line.
+    */
+    template<class T>
+    static inline size_t get_padded_row_size(const size_t columns) {
+        static_assert(CACHE_LINE_SIZE % sizeof(T) == 0, "elements must not straddle cache lines");
+        const auto elements_per_line = CACHE_LINE_SIZE / sizeof(T);
+        return (columns + elements_per_line - 1) / elements_per_line * elements_per_line;
+    }
+
 }
 
 
@@ -48,6 +48,38 @@ namespace {
 
     }
 
+    TEST_F(MemTests, AlignedMemory) {
+
+        auto options = mm::AllocationOptions();
+
+        for(auto page_size : {mm::PageSize::Default, mm::PageSize::TransparentHuge, mm::PageSize::Huge}) {
+            for(auto elements : {size_t(1), size_t(1000), mm::HUGE_PAGE_SIZE + 3}) {
+
+                options.page_size = page_size;
+                options.numa_policy = page_size == mm::PageSize::Default ? mm::NumaPolicy::Default : mm::NumaPolicy::Interleave;
+                auto ptr = mm::request_aligned_memory<int>(elements, options);
+                ASSERT_NE(ptr, nullptr);
+                ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % mm::CACHE_LINE_SIZE, 0u);
+
+                for(auto n = 0ul; n < elements; n++) {
+                    ASSERT_EQ(ptr[n], 0);
+                    ptr[n] = static_cast<int>(n);
+                }
+                ASSERT_EQ(ptr[elements - 1], static_cast<int>(elements - 1));
+
+                mm::release_aligned_memory(ptr);
+                ASSERT_EQ(ptr, nullptr);
+
+            }
+        }
+
+        ASSERT_EQ(mm::get_padded_row_size<float>(1), 16u);
+        ASSERT_EQ(mm::get_padded_row_size<float>(16), 16u);
+        ASSERT_EQ(mm::get_padded_row_size<uint16_t>(561), 576u);
+        ASSERT_EQ(mm::get_padded_row_size<double>(0), 0u);
+
+    }
+
 
 
 }
\ No newline at end of file
@@ -0,0 +1 @@
+#include "SparseIntSet.hpp"
\ No newline at end of file
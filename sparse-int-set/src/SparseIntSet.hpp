@@ -0,0 +1,95 @@
+#ifndef SPARSEINTSET_HPP
+#define SPARSEINTSET_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Set of integers in [0, capacity) made of a dense array listing the elements in insertion order and a sparse array
+ * storing the position of each element within the dense one. Insertions, lookups and removals take constant time
+ * without any allocation or hashing, clearing takes constant time as well and the elements can be iterated as a
+ * contiguous range.
+ */
+class SparseIntSet {
+
+    std::vector<int> dense;
+    std::vector<int> positions;
+    int elements_num = 0;
+
+public:
+
+    SparseIntSet() = default;
+
+    /**
+     * Builds an empty set.
+     * @param capacity elements are in [0, capacity)
+     */
+    explicit SparseIntSet(int capacity) : dense(static_cast<size_t>(capacity)), positions(static_cast<size_t>(capacity)) { }
+
+    /**
+     * Returns whether a value belongs to the set. Stale positions left by clear are harmless, since they either point
+     * past the last element or to a slot holding a different value.
+     * @param value value in [0, capacity)
+     * @return true if value belongs to the set, false otherwise
+     */
+    inline bool contains(int value) const {
+        assert(value >= 0 && value < capacity());
+        // the unsigned comparison also discards garbage negative positions
+        const auto position = static_cast<unsigned>(positions[value]);
+        return position < static_cast<unsigned>(elements_num) && dense[position] == value;
+    }
+
+    /**
+     * Adds a value to the set, if not already there.
+     * @param value value in [0, capacity)
+     */
+    inline void insert(int value) {
+        if(!contains(value)) {
+            positions[value] = elements_num;
+            dense[elements_num] = value;
+            elements_num++;
+        }
+    }
+
+    /**
+     * Removes a value from the set, if there, by moving the last element in its place.
+     * @param value value in [0, capacity)
+     */
+    inline void erase(int value) {
+        if(contains(value)) {
+            const auto position = positions[value];
+            const auto last = dense[elements_num - 1];
+            dense[position] = last;
+            positions[last] = position;
+            elements_num--;
+        }
+    }
+
+    /**
+     * Removes all the elements.
+     */
+    inline void clear() { elements_num = 0; }
+
+    /**
+     * Keeps only the first elements in iteration order, which are the first inserted ones as long as erase is not used.
+     * @param size number of elements to keep, not greater than the current size
+     */
+    inline void truncate(int size) {
+        assert(size >= 0 && size <= elements_num);
+        elements_num = size;
+    }
+
+    inline int size() const { return elements_num; }
+
+    inline bool empty() const { return elements_num == 0; }
+
+    inline int capacity() const { return static_cast<int>(dense.size()); }
+
+    inline const int *begin() const { return dense.data(); }
+
+    inline const int *end() const { return dense.data() + elements_num; }
+
+};
+
+#endif //SPARSEINTSET_HPP
@@ -0,0 +1,93 @@
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <SparseIntSet.hpp>
+
+using testing::Eq;
+
+namespace {
+
+    class SparseIntSetTests : public testing::Test {
+
+    public:
+
+        SparseIntSetTests() = default;
+
+    };
+
+    TEST_F(SparseIntSetTests, Usage) {
+
+        const auto capacity = 100;
+
+        auto set = SparseIntSet(capacity);
+        auto reference = std::set<int>();
+
+        ASSERT_TRUE(set.empty());
+        ASSERT_EQ(set.capacity(), capacity);
+
+        auto engine = std::mt19937(0);
+        auto distribution = std::uniform_int_distribution<int>(0, capacity - 1);
+
+        for(auto n = 0; n < 10000; n++) {
+
+            const auto value = distribution(engine);
+
+            switch(n % 7) {
+                case 0:
+                    set.erase(value);
+                    reference.erase(value);
+                    break;
+                case 6:
+                    if(n % 5 == 0) {
+                        set.clear();
+                        reference.clear();
+                    }
+                    break;
+                default:
+                    set.insert(value);
+                    reference.insert(value);
+                    break;
+            }
+
+            ASSERT_EQ(set.size(), static_cast<int>(reference.size()));
+            ASSERT_EQ(set.contains(value), reference.count(value) == 1);
+
+            // the elements are listed once each, in a contiguous range
+            auto elements = std::vector<int>(set.begin(), set.end());
+            std::sort(elements.begin(), elements.end());
+            ASSERT_EQ(elements, std::vector<int>(reference.begin(), reference.end()));
+
+        }
+
+        auto copy = set;
+        set.clear();
+        ASSERT_TRUE(set.empty());
+        ASSERT_EQ(copy.size(), static_cast<int>(reference.size()));
+        for(auto value : reference) {
+            ASSERT_TRUE(copy.contains(value));
+            ASSERT_FALSE(set.contains(value));
+        }
+
+    }
+
+    TEST_F(SparseIntSetTests, Truncate) {
+
+        auto set = SparseIntSet(10);
+        for(auto value : {7, 2, 9, 4}) {
+            set.insert(value);
+        }
+
+        set.truncate(2);
+        ASSERT_EQ(std::vector<int>(set.begin(), set.end()), std::vector<int>({7, 2}));
+        ASSERT_FALSE(set.contains(9));
+        ASSERT_FALSE(set.contains(4));
+
+        set.insert(4);
+        ASSERT_EQ(std::vector<int>(set.begin(), set.end()), std::vector<int>({7, 2, 4}));
+
+    }
+
+}
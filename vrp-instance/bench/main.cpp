@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <Instance.hpp>
+#include <CostsKernel.hpp>
+
+/*
+ * Micro-benchmark of the kernels filling the cost matrix. Each supported kernel computes all the rows of the matrix
+ * of the given instances, the best time out of a few repetitions is reported together with the speedup over the
+ * scalar kernel. Usage: vrp-instance-bench [path ...]
+ */
+int main(int argc, char* argv[]) {
+
+    auto paths = std::vector<std::string>();
+    for(auto n = 1; n < argc; n++) {
+        paths.emplace_back(argv[n]);
+    }
+    if(paths.empty()) {
+        paths = {"../../../instances/X/X-n106-k14.vrp", "../../../instances/VRP_Instances_Belgium/Leuven1.txt"};
+    }
+
+    const auto repetitions = 5;
+
+    auto options = Instance::Options();
+    options.costs_storage = Instance::CostsStorage::OnTheFly;
+    options.neighbors_num = 1;
+
+    for(const auto &path : paths) {
+
+        const auto instance = Instance(path, options);
+
+        if(!instance.is_valid()) {
+            std::cerr << "Cannot parse " << path << "\n";
+            continue;
+        }
+
+        const auto n = instance.get_vertices_num();
+
+        auto x = std::vector<float>(static_cast<size_t>(n));
+        auto y = std::vector<float>(static_cast<size_t>(n));
+        for(auto i = 0; i < n; i++) {
+            x[i] = instance.get_x_coordinate(i);
+            y[i] = instance.get_y_coordinate(i);
+        }
+
+        auto reference = std::vector<float>(static_cast<size_t>(n) * n);
+        auto matrix = std::vector<float>(static_cast<size_t>(n) * n);
+
+        std::cout << path << " (" << n << " vertices)\n";
+
+        auto scalar_time = 0.0;
+
+        for(const auto &kernel : get_supported_costs_row_kernels()) {
+
+            auto best_time = std::numeric_limits<double>::max();
+
+            for(auto repetition = 0; repetition < repetitions; repetition++) {
+                const auto begin = std::chrono::steady_clock::now();
+                for(auto i = 0; i < n; i++) {
+                    kernel.second(x.data(), y.data(), i, 0, n, true, &matrix[static_cast<size_t>(i) * n]);
+                }
+                const auto end = std::chrono::steady_clock::now();
+                best_time = std::min(best_time, std::chrono::duration<double, std::milli>(end - begin).count());
+            }
+
+            if(kernel.first == "scalar") {
+                scalar_time = best_time;
+                reference = matrix;
+            }
+
+            const auto identical = std::memcmp(reference.data(), matrix.data(), reference.size() * sizeof(float)) == 0;
+
+            std::cout << "  " << std::setw(8) << kernel.first << std::setw(12) << std::fixed << std::setprecision(3)
+                      << best_time << " ms" << std::setw(8) << std::setprecision(2) << scalar_time / best_time << "x"
+                      << (identical ? "" : "  MISMATCH") << "\n";
+
+        }
+
+    }
+
+    return 0;
+
+}
@@ -3,22 +3,78 @@
 //
 
 #include <fstream>
+#include <iostream>
+#include <streambuf>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include "AbstractInstance.hpp"
+#include "BinaryInstance.hpp"
+#include "CostsKernel.hpp"
 
-void serialize_TSPLIB(const AbstractInstance& instance, std::string& path);
-void serialize_json(const AbstractInstance& instance, std::string& path);
+bool serialize_TSPLIB(const AbstractInstance& instance, const std::string& path);
+bool serialize_json(const AbstractInstance& instance, const std::string& path);
+bool serialize_binary(const AbstractInstance& instance, const std::string& path, bool with_costs);
+BinaryInstanceHeader make_binary_header(const AbstractInstance& instance, bool with_costs);
+bool serialize_binary(const AbstractInstance& instance, const BinaryInstanceHeader& header, std::ostream& stream);
 
-void AbstractInstance::serialize(std::string &path, bool json) {
+namespace {
 
-    if(json) {
-        serialize_json(*this, path);
-    } else {
-        serialize_TSPLIB(*this, path);
+    /**
+     * Output buffer writing into a fixed size memory region, writes past its end fail.
+     */
+    class MemoryBuffer : public std::streambuf {
+
+    public:
+
+        MemoryBuffer(char *begin, size_t size) {
+            setp(begin, begin + size);
+        }
+
+    };
+
+}
+
+bool AbstractInstance::serialize(std::string &path, bool json) {
+
+    return serialize(path, json ? SerializationFormat::Json : SerializationFormat::TSPLIB);
+
+}
+
+bool AbstractInstance::serialize(const std::string &path, SerializationFormat format) const {
+
+    auto written = false;
+
+    switch(format) {
+        case SerializationFormat::Json:
+            written = serialize_json(*this, path);
+            break;
+        case SerializationFormat::Binary:
+            written = serialize_binary(*this, path, false);
+            break;
+        case SerializationFormat::BinaryWithCosts:
+            written = serialize_binary(*this, path, true);
+            break;
+        default:
+            written = serialize_TSPLIB(*this, path);
+            break;
     }
 
+    if(!written) {
+        std::cerr << "[::ERROR::] Cannot write instance: " << path << "\n";
+    }
+
+    return written;
+
 }
 
-void serialize_TSPLIB(const AbstractInstance &instance, std::string &path) {
+// text formats list the vertices in the order of the file the instance has been loaded from
+bool serialize_TSPLIB(const AbstractInstance &instance, const std::string &path) {
     auto stream = std::ofstream(path);
     stream << "NAME : name\n";
     stream << "COMMENT : (comment)\n";
@@ -29,39 +85,240 @@ void serialize_TSPLIB(const AbstractInstance &instance, std::string &path) {
     stream << "NODE_COORD_SECTION\n";
     stream << "1\t" << instance.get_x_coordinate(instance.get_depot()) << "\t" << instance.get_y_coordinate(instance.get_depot()) << "\n";
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
-        stream << (i+1) << "\t" << instance.get_x_coordinate(i) << "\t" << instance.get_y_coordinate(i) << "\n";
+        const auto vertex = instance.get_internal_id(i);
+        stream << (i+1) << "\t" << instance.get_x_coordinate(vertex) << "\t" << instance.get_y_coordinate(vertex) << "\n";
     }
     stream << "DEMAND_SECTION\n";
     stream << "1\t0\n";
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
-        stream << (i+1) << "\t" << instance.get_demand(i) << "\n";
+        stream << (i+1) << "\t" << instance.get_demand(instance.get_internal_id(i)) << "\n";
     }
     stream << "DEPOT_SECTION\n";
     stream << "\t1\n";
     stream << "\t-1\n";
     stream << "EOF\n";
     stream.close();
+    return static_cast<bool>(stream);
 }
 
-void serialize_json(const AbstractInstance &instance, std::string &path) {
+bool serialize_json(const AbstractInstance &instance, const std::string &path) {
     auto stream = std::ofstream(path);
+    const auto last = instance.get_internal_id(instance.get_vertices_end() - 1);
     stream << "{";
     stream << "\"x\":[";
     for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end() - 1; i++) {
-        stream << instance.get_x_coordinate(i) << ",";
+        stream << instance.get_x_coordinate(instance.get_internal_id(i)) << ",";
     }
-    stream << instance.get_x_coordinate(instance.get_vertices_end() - 1) << "],\n";
+    stream << instance.get_x_coordinate(last) << "],\n";
     stream << "\"y\":[";
     for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end() - 1; i++) {
-        stream << instance.get_y_coordinate(i) << ",";
+        stream << instance.get_y_coordinate(instance.get_internal_id(i)) << ",";
     }
-    stream << instance.get_y_coordinate(instance.get_vertices_end() - 1) << "],\n";
+    stream << instance.get_y_coordinate(last) << "],\n";
     stream << "\"Q\":" << instance.get_vehicle_capacity() << ",\n";
     stream << "\"q\":[";
     for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end() - 1; i++) {
-        stream << instance.get_demand(i) << ",";
+        stream << instance.get_demand(instance.get_internal_id(i)) << ",";
     }
-    stream << instance.get_demand(instance.get_vertices_end() - 1) << "]\n";
+    stream << instance.get_demand(last) << "]\n";
     stream << "}\n";
     stream.close();
-}
\ No newline at end of file
+    return static_cast<bool>(stream);
+}
+
+bool AbstractInstance::share(const std::string &name, bool with_costs, bool replace) const {
+
+    // a new object is always created, processes attached to a replaced one keep a consistent view of it
+    if(replace) {
+        shm_unlink(name.c_str());
+    }
+    const auto descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(descriptor < 0) {
+        if(errno == EEXIST) {
+            std::cerr << "[::ERROR::] Shared memory instance already exists: " << name << "\n";
+        } else {
+            std::cerr << "[::ERROR::] Cannot create shared memory instance: " << name << "\n";
+        }
+        return false;
+    }
+
+    // shared memory objects are only guaranteed to support being sized and mapped, not written to
+    const auto header = make_binary_header(*this, with_costs);
+    const auto size = static_cast<size_t>(header.file_size);
+    auto written = ftruncate(descriptor, static_cast<off_t>(size)) == 0;
+    if(written) {
+        const auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        written = memory != MAP_FAILED;
+        if(written) {
+            MemoryBuffer buffer(static_cast<char *>(memory), size);
+            std::ostream stream(&buffer);
+            written = serialize_binary(*this, header, stream);
+            munmap(memory, size);
+        }
+    }
+    close(descriptor);
+
+    if(!written) {
+        std::cerr << "[::ERROR::] Cannot write shared memory instance: " << name << "\n";
+        shm_unlink(name.c_str());
+    }
+
+    return written;
+
+}
+
+bool AbstractInstance::unshare(const std::string &name) {
+
+    return shm_unlink(name.c_str()) == 0;
+
+}
+
+template<class T>
+void write_binary_costs(const AbstractInstance &instance, std::ostream &stream) {
+    auto row = std::vector<T>(static_cast<size_t>(instance.get_vertices_num()));
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        for (auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+            row[j] = static_cast<T>(instance.get_cost(i, j));
+        }
+        stream.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(T)));
+    }
+}
+
+bool serialize_binary(const AbstractInstance &instance, const std::string &path, bool with_costs) {
+
+    auto stream = std::ofstream(path, std::ios::binary);
+    if(!stream) {
+        return false;
+    }
+
+    serialize_binary(instance, make_binary_header(instance, with_costs), stream);
+    stream.close();
+
+    // partially written files are not left behind
+    if(!stream) {
+        std::remove(path.c_str());
+        return false;
+    }
+
+    return true;
+
+}
+
+BinaryInstanceHeader make_binary_header(const AbstractInstance &instance, bool with_costs) {
+
+    const auto n = static_cast<uint64_t>(instance.get_vertices_num());
+    const auto k = instance.get_neighbors_of(instance.get_vertices_begin()).size();
+
+    auto header = BinaryInstanceHeader();
+    std::memcpy(header.magic, BINARY_INSTANCE_MAGIC, sizeof(header.magic));
+    header.version = BINARY_INSTANCE_VERSION;
+    header.byte_order = BINARY_INSTANCE_BYTE_ORDER;
+    header.vertices_num = instance.get_vertices_num();
+    header.vehicle_capacity = instance.get_vehicle_capacity();
+    header.neighbors_num = static_cast<int32_t>(k);
+    header.integer_costs = instance.has_integer_costs();
+    header.costs_type = BinaryCostsType::None;
+
+    if(with_costs) {
+        header.costs_type = BinaryCostsType::Float;
+        if(instance.has_integer_costs()) {
+            // no cost can exceed the diagonal of the bounding box
+            auto min_x = std::numeric_limits<float>::max(), max_x = std::numeric_limits<float>::lowest();
+            auto min_y = min_x, max_y = max_x;
+            for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                min_x = std::min(min_x, instance.get_x_coordinate(i));
+                max_x = std::max(max_x, instance.get_x_coordinate(i));
+                min_y = std::min(min_y, instance.get_y_coordinate(i));
+                max_y = std::max(max_y, instance.get_y_coordinate(i));
+            }
+            const auto max_cost = euclidean_cost(min_x, min_y, max_x, max_y, true);
+            header.costs_type = max_cost + 1.0f <= std::numeric_limits<uint16_t>::max() ? BinaryCostsType::UInt16 : BinaryCostsType::Int32;
+        }
+    }
+
+    header.x_coordinates_offset = align_binary_instance_offset(sizeof(BinaryInstanceHeader));
+    header.y_coordinates_offset = align_binary_instance_offset(header.x_coordinates_offset + n * sizeof(float));
+    header.demands_offset = align_binary_instance_offset(header.y_coordinates_offset + n * sizeof(float));
+    header.neighbors_offset = align_binary_instance_offset(header.demands_offset + n * sizeof(int32_t));
+    auto renumbered = false;
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        renumbered = renumbered || instance.get_external_id(i) != i;
+    }
+    auto section_end = header.neighbors_offset + n * k * sizeof(Neighbor);
+    header.external_ids_offset = 0;
+    if(renumbered) {
+        header.external_ids_offset = align_binary_instance_offset(section_end);
+        section_end = header.external_ids_offset + n * sizeof(int32_t);
+    }
+    header.costs_offset = align_binary_instance_offset(section_end);
+    header.file_size = header.costs_offset + n * n * get_binary_costs_element_size(header.costs_type);
+
+    return header;
+
+}
+
+bool serialize_binary(const AbstractInstance &instance, const BinaryInstanceHeader &header, std::ostream &stream) {
+
+    const auto n = static_cast<uint64_t>(instance.get_vertices_num());
+    const auto k = static_cast<uint64_t>(header.neighbors_num);
+    const auto renumbered = header.external_ids_offset != 0;
+
+    auto position = uint64_t(0);
+
+    const auto write = [&stream, &position](uint64_t offset, const void *data, uint64_t size) {
+        static const char padding[BINARY_INSTANCE_ALIGNMENT] = {};
+        stream.write(padding, static_cast<std::streamsize>(offset - position));
+        stream.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+        position = offset + size;
+    };
+
+    write(0, &header, sizeof(header));
+
+    auto floats = std::vector<float>(n);
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        floats[i] = instance.get_x_coordinate(i);
+    }
+    write(header.x_coordinates_offset, floats.data(), n * sizeof(float));
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        floats[i] = instance.get_y_coordinate(i);
+    }
+    write(header.y_coordinates_offset, floats.data(), n * sizeof(float));
+
+    auto ints = std::vector<int32_t>(n);
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        ints[i] = instance.get_demand(i);
+    }
+    write(header.demands_offset, ints.data(), n * sizeof(int32_t));
+
+    auto neighbors = std::vector<Neighbor>(n * k);
+    for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+        const auto entries = instance.get_neighbor_entries_of(i);
+        std::copy(entries.begin(), entries.end(), &neighbors[i * k]);
+    }
+    write(header.neighbors_offset, neighbors.data(), n * k * sizeof(Neighbor));
+
+    if(renumbered) {
+        for (auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+            ints[i] = instance.get_external_id(i);
+        }
+        write(header.external_ids_offset, ints.data(), n * sizeof(int32_t));
+    }
+
+    write(header.costs_offset, nullptr, 0);
+    switch(header.costs_type) {
+        case BinaryCostsType::Float:
+            write_binary_costs<float>(instance, stream);
+            break;
+        case BinaryCostsType::Int32:
+            write_binary_costs<int32_t>(instance, stream);
+            break;
+        case BinaryCostsType::UInt16:
+            write_binary_costs<uint16_t>(instance, stream);
+            break;
+        default:
+            break;
+    }
+
+    return static_cast<bool>(stream);
+
+}
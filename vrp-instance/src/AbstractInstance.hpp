@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <string>
+#include "Neighbors.hpp"
 
 /**
  * Interface defining the functionalities an instance-like class must define.
@@ -16,6 +17,29 @@ class AbstractInstance {
 
 public:
 
+    /**
+     * Formats an instance can be saved in.
+     */
+    enum class SerializationFormat {
+        /**
+         * Text file following the TSPLIB format.
+         */
+        TSPLIB,
+        /**
+         * Text file in a json format.
+         */
+        Json,
+        /**
+         * Versioned binary file holding coordinates, demands, capacity and neighbors lists, which the Instance class
+         * memory-maps and uses without parsing. Costs are computed from the coordinates when the file is loaded.
+         */
+        Binary,
+        /**
+         * Same as Binary, but the cost matrix is stored as well. Rounded costs are stored as 16 or 32 bits integers.
+         */
+        BinaryWithCosts
+    };
+
     /**
      * Returns whether or not the instance is valid, i.e. the instance file has been successfully parsed and the 
      * corresponding instance is a feasible CVRP.
@@ -83,6 +107,22 @@ public:
      */
     virtual float get_cost(int i, int j) const = 0;
 
+    /**
+     * Returns whether all the costs are integer values, e.g. when they are rounded. In such a case get_integer_cost
+     * can be used to avoid floating point arithmetic.
+     * @return true if costs are integer values, false otherwise
+     */
+    virtual bool has_integer_costs() const = 0;
+
+    /**
+     * Returns the cost of the edge between i and j as an integer. The result is meaningful only when
+     * has_integer_costs is true, otherwise it is the truncated cost.
+     * @param i vertex
+     * @param j vertex
+     * @return cost of the (i, j) edge
+     */
+    virtual int get_integer_cost(int i, int j) const = 0;
+
     /**
      * Returns the vertex demand.
      * @param i vertex
@@ -105,21 +145,95 @@ public:
     virtual float get_y_coordinate(int i) const  = 0;
 
     /**
-     * Returns a reference to an array of vertices sorted according to increasing cost from i. The array includes i
+     * Returns a view over the nearest vertices sorted according to increasing cost from i. The view includes i
      * itself in the first position. Note that this must be enforced, it is not always automatically obtained just by
-     * sorting the vertices (e.g. when i and some other vertices overlap).
+     * sorting the vertices (e.g. when i and some other vertices overlap). The number of neighbors is defined when
+     * building the instance and it may be smaller than the number of vertices.
+     * @param i vertex
+     * @return view over the neighbors array
+     */
+    virtual NeighborsView get_neighbors_of(int i) const = 0;
+
+    /**
+     * Returns the same neighbors as get_neighbors_of together with their cost from i, which equals get_cost(i, j).
+     * The entries of a vertex are contiguous, hence granular neighborhoods can be scanned without accessing the costs.
      * @param i vertex
-     * @return reference to the neighbors array
+     * @return view over the neighbors entries
      */
-    virtual std::vector<int>& get_neighbors_of(int i) = 0;
+    virtual NeighborsSpan get_neighbor_entries_of(int i) const = 0;
+
+    /**
+     * Retrieves the k vertices closest to the point (x, y) according to the euclidean distance, sorted by increasing
+     * distance. It runs in logarithmic expected time thanks to a spatial index built together with the instance.
+     * @param x x-coordinate of the query point
+     * @param y y-coordinate of the query point
+     * @param k number of vertices to retrieve, if larger than the number of vertices all of them are retrieved
+     * @param vertices where the vertices are stored, any previous content is cleared
+     */
+    virtual void get_nearest_vertices(float x, float y, int k, std::vector<int>& vertices) const = 0;
+
+    /**
+     * Retrieves the vertices whose euclidean distance from the point (x, y) is at most radius, sorted by increasing
+     * distance.
+     * @param x x-coordinate of the query point
+     * @param y y-coordinate of the query point
+     * @param radius query radius
+     * @param vertices where the vertices are stored, any previous content is cleared
+     */
+    virtual void get_vertices_within_radius(float x, float y, float radius, std::vector<int>& vertices) const = 0;
+
+    /**
+     * Returns the identifier a vertex has in the file the instance has been loaded from, which differs from the
+     * vertex itself only when the instance renumbers its vertices.
+     * @param i vertex
+     * @return external identifier
+     */
+    virtual int get_external_id(int i) const { return i; }
+
+    /**
+     * Returns the vertex corresponding to an identifier of the file the instance has been loaded from. It is the
+     * inverse of get_external_id, identifiers outside the vertices range are returned as they are.
+     * @param external_id external identifier
+     * @return vertex
+     */
+    virtual int get_internal_id(int external_id) const { return external_id; }
 
     /**
      * Save to file the instance following the TSPLIB format. If the json parameter is set to true, the instance is
      * instead saved in a json format.
      * @param path where to save the file
      * @param json whether to save the instance in a json format
+     * @return true if the file has been written, false otherwise
+     */
+    bool serialize(std::string& path, bool json);
+
+    /**
+     * Save to file the instance in the given format. Binary files which cannot be completely written are removed, so
+     * that they are never mapped in a truncated state.
+     * @param path where to save the file
+     * @param format file format
+     * @return true if the file has been written, false otherwise
+     */
+    bool serialize(const std::string& path, SerializationFormat format) const;
+
+    /**
+     * Stores the instance in a POSIX shared memory object with the SerializationFormat::Binary or BinaryWithCosts
+     * layout. Other processes can then attach it read-only by building an Instance with Options::shared_memory, which
+     * costs no parsing nor copies and makes all of them share the same physical pages. Attaching fails until this
+     * method has returned. The object persists until it is removed.
+     * @param name shared memory object name, of the form /some-name
+     * @param with_costs whether the cost matrix is stored as well
+     * @param replace whether an existing object with the same name is removed first, otherwise sharing fails
+     * @return true if the object has been written, false otherwise
+     */
+    bool share(const std::string& name, bool with_costs = true, bool replace = false) const;
+
+    /**
+     * Removes a shared memory object created by share. Processes which have already attached it keep using it.
+     * @param name shared memory object name
+     * @return true if the object has been removed, false otherwise
      */
-    void serialize(std::string& path, bool json);
+    static bool unshare(const std::string& name);
 
 };
 
@@ -0,0 +1,104 @@
+#ifndef VRP_BINARYINSTANCE_HPP
+#define VRP_BINARYINSTANCE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Identifies a binary instance file, it is stored in the first bytes of the header.
+ */
+constexpr char BINARY_INSTANCE_MAGIC[8] = {'C', 'V', 'R', 'P', 'B', 'I', 'N', '\0'};
+
+/**
+ * Version of the binary layout, files written with a different version are rejected.
+ */
+constexpr uint32_t BINARY_INSTANCE_VERSION = 3;
+
+/**
+ * Written as a native integer to detect files produced on a machine with a different endianness.
+ */
+constexpr uint32_t BINARY_INSTANCE_BYTE_ORDER = 0x01020304;
+
+/**
+ * Sections are aligned to a cache line so that a memory-mapped file can be accessed as is.
+ */
+constexpr uint64_t BINARY_INSTANCE_ALIGNMENT = 64;
+
+/**
+ * Element type of the cost matrix stored in a binary instance file.
+ */
+enum class BinaryCostsType : uint32_t {
+    None = 0,
+    Float = 1,
+    Int32 = 2,
+    UInt16 = 3
+};
+
+/**
+ * Header of a binary instance file. It is followed by the coordinates, the demands, the neighbors lists and the
+ * optional cost matrix, each one starting at the given offset from the beginning of the file. Neighbors lists are
+ * stored as vertices_num x neighbors_num entries made of a 32 bits vertex and its 32 bits float cost. The optional
+ * external identifiers section stores, for each vertex, its identifier in the original file and is only present when
+ * the vertices have been renumbered, otherwise its offset is 0. The cost matrix is a full vertices_num x vertices_num
+ * row-major matrix.
+ */
+struct BinaryInstanceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t vertices_num;
+    int32_t vehicle_capacity;
+    int32_t neighbors_num;
+    BinaryCostsType costs_type;
+    uint32_t integer_costs;
+    uint32_t reserved;
+    uint64_t x_coordinates_offset;
+    uint64_t y_coordinates_offset;
+    uint64_t demands_offset;
+    uint64_t neighbors_offset;
+    uint64_t external_ids_offset;
+    uint64_t costs_offset;
+    uint64_t file_size;
+};
+
+static_assert(std::is_trivially_copyable<BinaryInstanceHeader>::value, "the header is written and read as raw bytes");
+
+/**
+ * Returns the smallest offset not smaller than the given one that satisfies the sections alignment.
+ * @param offset offset from the beginning of the file
+ * @return aligned offset
+ */
+inline uint64_t align_binary_instance_offset(uint64_t offset) {
+    return (offset + BINARY_INSTANCE_ALIGNMENT - 1) & ~(BINARY_INSTANCE_ALIGNMENT - 1);
+}
+
+/**
+ * Returns the size in bytes of a cost matrix element.
+ * @param type element type
+ * @return element size
+ */
+inline uint64_t get_binary_costs_element_size(BinaryCostsType type) {
+    switch(type) {
+        case BinaryCostsType::Float:
+            return sizeof(float);
+        case BinaryCostsType::Int32:
+            return sizeof(int32_t);
+        case BinaryCostsType::UInt16:
+            return sizeof(uint16_t);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Returns whether the given bytes start with the binary instance magic.
+ * @param data file content
+ * @param size number of available bytes
+ * @return true if the content is a binary instance, false otherwise
+ */
+inline bool is_binary_instance(const void *data, size_t size) {
+    return size >= sizeof(BINARY_INSTANCE_MAGIC) && std::memcmp(data, BINARY_INSTANCE_MAGIC, sizeof(BINARY_INSTANCE_MAGIC)) == 0;
+}
+
+#endif //VRP_BINARYINSTANCE_HPP
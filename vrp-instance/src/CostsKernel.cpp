@@ -0,0 +1,104 @@
+#include "CostsKernel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VRP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+void compute_costs_row_scalar(const float *x, const float *y, int i, int begin, int end, bool round_costs, float *costs) {
+    for(auto j = begin; j < end; j++) {
+        costs[j - begin] = euclidean_cost(x[i], y[i], x[j], y[j], round_costs);
+    }
+}
+
+#ifdef VRP_X86_KERNELS
+
+// std::round rounds halfway cases away from zero while the SIMD rounding modes round them to even. Since costs are
+// non-negative, rounding is performed as trunc(cost) + (cost - trunc(cost) >= 0.5), where the subtraction is exact.
+
+__attribute__((target("avx2")))
+static inline __m256 round_costs_avx2(__m256 costs) {
+    const auto truncated = _mm256_round_ps(costs, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const auto up = _mm256_cmp_ps(_mm256_sub_ps(costs, truncated), _mm256_set1_ps(0.5f), _CMP_GE_OQ);
+    return _mm256_add_ps(truncated, _mm256_and_ps(up, _mm256_set1_ps(1.0f)));
+}
+
+__attribute__((target("avx2")))
+static void compute_costs_row_avx2(const float *x, const float *y, int i, int begin, int end, bool round_costs, float *costs) {
+
+    const auto xi = _mm256_set1_ps(x[i]);
+    const auto yi = _mm256_set1_ps(y[i]);
+
+    auto j = begin;
+
+    for(; j + 8 <= end; j += 8) {
+        const auto dx = _mm256_sub_ps(xi, _mm256_loadu_ps(&x[j]));
+        const auto dy = _mm256_sub_ps(yi, _mm256_loadu_ps(&y[j]));
+        auto cost = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+        if(round_costs) {
+            cost = round_costs_avx2(cost);
+        }
+        _mm256_storeu_ps(&costs[j - begin], cost);
+    }
+
+    compute_costs_row_scalar(x, y, i, j, end, round_costs, &costs[j - begin]);
+
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 round_costs_avx512(__m512 costs) {
+    // the explicit source forms avoid the GCC maybe-uninitialized false positive of the unmasked intrinsics
+    const auto truncated = _mm512_mask_roundscale_ps(costs, 0xFFFF, costs, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const auto up = _mm512_cmp_ps_mask(_mm512_sub_ps(costs, truncated), _mm512_set1_ps(0.5f), _CMP_GE_OQ);
+    return _mm512_mask_add_ps(truncated, up, truncated, _mm512_set1_ps(1.0f));
+}
+
+__attribute__((target("avx512f")))
+static void compute_costs_row_avx512(const float *x, const float *y, int i, int begin, int end, bool round_costs, float *costs) {
+
+    const auto xi = _mm512_set1_ps(x[i]);
+    const auto yi = _mm512_set1_ps(y[i]);
+
+    for(auto j = begin; j < end; j += 16) {
+
+        // the tail is processed with masked loads and stores
+        const auto mask = static_cast<__mmask16>(end - j >= 16 ? 0xFFFF : (1u << (end - j)) - 1u);
+
+        const auto dx = _mm512_sub_ps(xi, _mm512_maskz_loadu_ps(mask, &x[j]));
+        const auto dy = _mm512_sub_ps(yi, _mm512_maskz_loadu_ps(mask, &y[j]));
+        const auto squared_cost = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+        auto cost = _mm512_mask_sqrt_ps(squared_cost, 0xFFFF, squared_cost);
+        if(round_costs) {
+            cost = round_costs_avx512(cost);
+        }
+        _mm512_mask_storeu_ps(&costs[j - begin], mask, cost);
+
+    }
+
+}
+
+#endif
+
+CostsRowKernel get_costs_row_kernel() {
+    return get_supported_costs_row_kernels().back().second;
+}
+
+std::vector<std::pair<std::string, CostsRowKernel>> get_supported_costs_row_kernels() {
+
+    auto kernels = std::vector<std::pair<std::string, CostsRowKernel>>();
+
+    kernels.emplace_back("scalar", compute_costs_row_scalar);
+
+#ifdef VRP_X86_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        kernels.emplace_back("avx2", compute_costs_row_avx2);
+    }
+    if(__builtin_cpu_supports("avx512f")) {
+        kernels.emplace_back("avx512", compute_costs_row_avx512);
+    }
+#endif
+
+    return kernels;
+
+}
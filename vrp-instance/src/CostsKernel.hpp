@@ -0,0 +1,49 @@
+#ifndef VRP_COSTSKERNEL_HPP
+#define VRP_COSTSKERNEL_HPP
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Returns the euclidean cost between two points, optionally rounded to the nearest integer. This is the reference
+ * definition of the costs, every kernel below produces bit-identical results.
+ * Note that the project is compiled with -ffp-contract=off so that the compiler cannot fuse the multiplications and
+ * the addition into an FMA, which would change the last bit of some costs depending on the target architecture.
+ * @param xi x-coordinate of the first point
+ * @param yi y-coordinate of the first point
+ * @param xj x-coordinate of the second point
+ * @param yj y-coordinate of the second point
+ * @param round_cost whether the cost is rounded
+ * @return cost
+ */
+inline float euclidean_cost(float xi, float yi, float xj, float yj, bool round_cost) {
+    const auto cost = std::sqrt((xi - xj) * (xi - xj) + (yi - yj) * (yi - yj));
+    return round_cost ? std::round(cost) : cost;
+}
+
+/**
+ * Function computing costs[j - begin] = euclidean_cost(x[i], y[i], x[j], y[j], round_costs) for all j in [begin, end).
+ */
+using CostsRowKernel = void (*)(const float *x, const float *y, int i, int begin, int end, bool round_costs, float *costs);
+
+/**
+ * Portable implementation of CostsRowKernel.
+ */
+void compute_costs_row_scalar(const float *x, const float *y, int i, int begin, int end, bool round_costs, float *costs);
+
+/**
+ * Returns the fastest CostsRowKernel supported by the running CPU (AVX-512, AVX2 or the scalar fallback).
+ * @return kernel
+ */
+CostsRowKernel get_costs_row_kernel();
+
+/**
+ * Returns all the CostsRowKernel supported by the running CPU together with their names, from the slowest to the
+ * fastest one. Mainly useful for testing and benchmarking.
+ * @return kernels
+ */
+std::vector<std::pair<std::string, CostsRowKernel>> get_supported_costs_row_kernels();
+
+#endif //VRP_COSTSKERNEL_HPP
@@ -6,78 +6,465 @@
 #include <cmath>
 #include "Instance.hpp"
 #include <algorithm>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BinaryInstance.hpp"
+#include "Parallel.hpp"
 
 
-Instance::Instance(const std::string &path, bool round_costs) {
+Instance::Instance(const std::string &path, bool round_costs) : Instance(path, Options{round_costs, CostsStorage::Matrix}) { }
 
-    valid = parse_zachariadis_kironoudis_instance(path) || parse_golden_instance(path) || parse_x_instance(path);
+Instance::Instance(const std::string &path, const Options &options) {
+
+    round_costs = options.round_costs;
+    costs_storage = options.costs_storage;
+    neighbors_num = options.neighbors_num;
+    threads_num = resolve_threads_num(options.threads_num);
+    huge_pages = options.huge_pages;
+    padded_rows = options.padded_rows;
+    numa_interleave = options.numa_interleave;
+    costs_format = options.round_costs && options.integer_costs ? CostsFormat::Int32 : CostsFormat::Float;
+
+    if(options.shared_memory) {
+        valid = attach_shared_memory(path);
+        return;
+    }
+
+    auto is_binary = false;
+    valid = map_binary_instance(path, is_binary);
+
+    if(is_binary) {
+        return;
+    }
+
+    valid = parse_text_instance(path);
 
     if(!valid) {
         return;
     }
 
-    initialize_data_structures(round_costs);
+    if(options.vertices_ordering != VerticesOrdering::File) {
+        renumber_vertices(options.vertices_ordering);
+    }
+
+    initialize_data_structures();
+
+}
+
+Instance::~Instance() = default;
+
+void Instance::MappedMemoryRelease::operator()(void *memory) const {
+    munmap(memory, size);
+}
+
+void Instance::AlignedMemoryRelease::operator()(void *memory) const {
+    mm::release_aligned_bytes(memory);
+}
+
+bool Instance::map_binary_instance(const std::string &path, bool &is_binary) {
+
+    is_binary = false;
+
+    const auto descriptor = open(path.c_str(), O_RDONLY);
+    if(descriptor < 0) {
+        return false;
+    }
+
+    return map_binary_descriptor(descriptor, path, is_binary);
 
 }
 
-Instance::~Instance() {
-    mm::release_raw_contiguous_memory(costs_matrix);
+bool Instance::attach_shared_memory(const std::string &name) {
+
+    const auto descriptor = shm_open(name.c_str(), O_RDONLY, 0);
+    if(descriptor < 0) {
+        std::cerr << "[::ERROR::] Cannot open shared memory instance: " << name << "\n";
+        return false;
+    }
+
+    auto is_binary = false;
+    const auto attached = map_binary_descriptor(descriptor, name, is_binary);
+    if(!is_binary) {
+        std::cerr << "[::ERROR::] Malformed or unsupported binary instance: " << name << "\n";
+    }
+
+    return attached;
+
 }
 
-void Instance::initialize_data_structures(bool round_costs) {
+bool Instance::map_binary_descriptor(int descriptor, const std::string &path, bool &is_binary) {
+
+    is_binary = false;
+
+    struct stat status = {};
+    if(fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(BinaryInstanceHeader)) {
+        close(descriptor);
+        return false;
+    }
+
+    auto header = BinaryInstanceHeader();
+    if(pread(descriptor, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+       !is_binary_instance(&header, sizeof(header))) {
+        close(descriptor);
+        return false;
+    }
+
+    is_binary = true;
+
+    const auto size = static_cast<uint64_t>(status.st_size);
+    const auto n = static_cast<uint64_t>(header.vertices_num);
+    const auto k = static_cast<uint64_t>(header.neighbors_num);
+    const auto fits = [size](uint64_t offset, uint64_t bytes) {
+        return offset % BINARY_INSTANCE_ALIGNMENT == 0 && offset <= size && bytes <= size - offset;
+    };
+
+    if(header.version != BINARY_INSTANCE_VERSION || header.byte_order != BINARY_INSTANCE_BYTE_ORDER ||
+       header.file_size != size || header.vertices_num < 1 || header.neighbors_num < 1 ||
+       header.neighbors_num > header.vertices_num || header.costs_type > BinaryCostsType::UInt16 ||
+       !fits(header.x_coordinates_offset, n * sizeof(float)) || !fits(header.y_coordinates_offset, n * sizeof(float)) ||
+       !fits(header.demands_offset, n * sizeof(int32_t)) || !fits(header.neighbors_offset, n * k * sizeof(Neighbor)) ||
+       (header.external_ids_offset != 0 && !fits(header.external_ids_offset, n * sizeof(int32_t))) ||
+       !fits(header.costs_offset, n * n * get_binary_costs_element_size(header.costs_type))) {
+        std::cerr << "[::ERROR::] Malformed or unsupported binary instance: " << path << "\n";
+        close(descriptor);
+        return false;
+    }
+
+    // shared read-only pages are backed by the page cache, which all the processes mapping the file share
+    auto memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if(memory == MAP_FAILED) {
+        std::cerr << "[::ERROR::] Cannot map binary instance: " << path << "\n";
+        return false;
+    }
+
+    mapped_memory = std::unique_ptr<void, MappedMemoryRelease>(memory, MappedMemoryRelease(size));
+
+    const auto bytes = static_cast<const char *>(memory);
 
+    matrix_size = header.vertices_num;
+    capacity = header.vehicle_capacity;
     depot = 0;
     customers_num = matrix_size - 1;
     customers_begin = 1;
     customers_end = matrix_size;
-    costs_matrix = mm::request_raw_contiguous_memory<float>(matrix_size, matrix_size);
+    round_costs = header.integer_costs != 0;
+
+    x_coordinates_ptr = reinterpret_cast<const float *>(bytes + header.x_coordinates_offset);
+    y_coordinates_ptr = reinterpret_cast<const float *>(bytes + header.y_coordinates_offset);
+    demands_ptr = reinterpret_cast<const int *>(bytes + header.demands_offset);
+    neighbors_ptr = reinterpret_cast<const Neighbor *>(bytes + header.neighbors_offset);
+    neighbors_num = header.neighbors_num;
+
+    if(header.external_ids_offset != 0) {
+        external_ids_ptr = reinterpret_cast<const int *>(bytes + header.external_ids_offset);
+        internal_ids.assign(static_cast<size_t>(matrix_size), -1);
+        for(auto i = 0; i < matrix_size; i++) {
+            const auto external_id = external_ids_ptr[i];
+            if(external_id < 0 || external_id >= matrix_size || internal_ids[external_id] != -1) {
+                std::cerr << "[::ERROR::] Malformed binary instance identifiers: " << path << "\n";
+                return false;
+            }
+            internal_ids[external_id] = i;
+        }
+    }
+
+    // neighbors are used as indices without further checks
+    for(auto entry = neighbors_ptr; entry < neighbors_ptr + n * k; entry++) {
+        if(entry->vertex < 0 || entry->vertex >= matrix_size) {
+            std::cerr << "[::ERROR::] Malformed binary instance neighbors: " << path << "\n";
+            return false;
+        }
+    }
+
+    const auto costs = bytes + header.costs_offset;
+    costs_stride = static_cast<size_t>(matrix_size);
+    costs_storage = CostsStorage::Matrix;
+    switch(header.costs_type) {
+        case BinaryCostsType::Float:
+            costs_format = CostsFormat::Float;
+            float_costs = reinterpret_cast<const float *>(costs);
+            break;
+        case BinaryCostsType::Int32:
+            costs_format = CostsFormat::Int32;
+            int32_costs = reinterpret_cast<const int32_t *>(costs);
+            break;
+        case BinaryCostsType::UInt16:
+            costs_format = CostsFormat::UInt16;
+            uint16_costs = reinterpret_cast<const uint16_t *>(costs);
+            break;
+        default:
+            costs_format = CostsFormat::Float;
+            costs_storage = CostsStorage::OnTheFly;
+            break;
+    }
+
+    resolve_costs_layout();
+
+    spatial_index = KdTree(x_coordinates_ptr, y_coordinates_ptr, matrix_size);
+
+    return true;
+
+}
+
+void Instance::resolve_costs_layout() {
+    const auto triangular = costs_storage == CostsStorage::TriangularMatrix;
+    switch(costs_format) {
+        case CostsFormat::UInt16:
+            costs_layout = triangular ? CostsLayout::UInt16TriangularMatrix : CostsLayout::UInt16Matrix;
+            break;
+        case CostsFormat::Int32:
+            costs_layout = triangular ? CostsLayout::Int32TriangularMatrix : CostsLayout::Int32Matrix;
+            break;
+        default:
+            costs_layout = triangular ? CostsLayout::FloatTriangularMatrix : CostsLayout::FloatMatrix;
+            break;
+    }
+    if(costs_storage == CostsStorage::OnTheFly) {
+        costs_layout = CostsLayout::OnTheFly;
+    }
+}
+
+size_t Instance::get_costs_elements() const {
+    switch(costs_storage) {
+        case CostsStorage::Matrix:
+            return static_cast<size_t>(matrix_size) * costs_stride;
+        case CostsStorage::TriangularMatrix:
+            return static_cast<size_t>(matrix_size) * (static_cast<size_t>(matrix_size) + 1) / 2;
+        default:
+            return 0;
+    }
+}
+
+size_t Instance::get_costs_memory_usage() const {
+    const auto elements = get_costs_elements();
+    switch(costs_format) {
+        case CostsFormat::UInt16:
+            return elements * sizeof(uint16_t);
+        case CostsFormat::Int32:
+            return elements * sizeof(int32_t);
+        default:
+            return elements * sizeof(float);
+    }
+}
+
+template<class T>
+void Instance::fill_costs_matrix(T *costs) {
+
+    // each thread fills whole rows with contiguous writes. In a full matrix both halves are computed to avoid
+    // sharing rows, while in a triangular one row i only contains the costs towards j <= i
+    const auto kernel = get_costs_row_kernel();
+    const auto triangular = costs_storage == CostsStorage::TriangularMatrix;
+
+    const auto fill_row = [this, kernel, costs, triangular](int i, std::vector<float> &row) {
+        const auto offset = get_cost_index(i, 0);
+        const auto size = triangular ? i + 1 : matrix_size;
+        if(std::is_same<T, float>::value) {
+            kernel(x_coordinates_ptr, y_coordinates_ptr, i, 0, size, round_costs, reinterpret_cast<float *>(&costs[offset]));
+        } else {
+            // rounded costs are integer values, the conversion is exact
+            kernel(x_coordinates_ptr, y_coordinates_ptr, i, 0, size, round_costs, row.data());
+            for(auto j = 0; j < size; j++) {
+                costs[offset + j] = static_cast<T>(row[j]);
+            }
+        }
+    };
 
-    for(auto i = 0; i < matrix_size - 1; i++) {
-        costs_matrix[i][i] = 0.0f;
-        for(auto j = i + 1; j < matrix_size; j++) {
+    if(triangular) {
 
-            costs_matrix[i][j] = std::sqrt((x_coordinates[i] - x_coordinates[j]) * (x_coordinates[i] - x_coordinates[j]) + (y_coordinates[i] - y_coordinates[j]) * (y_coordinates[i] - y_coordinates[j]));
+        // rows i and matrix_size - 1 - i together have a constant length, pairing them balances the threads load
+        parallel_for(0, (matrix_size + 1) / 2, threads_num, [this, &fill_row](int begin, int end) {
+            auto row = std::vector<float>(std::is_same<T, float>::value ? 0 : matrix_size);
+            for(auto i = begin; i < end; i++) {
+                fill_row(i, row);
+                if(matrix_size - 1 - i != i) {
+                    fill_row(matrix_size - 1 - i, row);
+                }
+            }
+        });
 
-            if(round_costs) {
-                costs_matrix[i][j] = std::round(costs_matrix[i][j]);
+    } else {
+
+        parallel_for(0, matrix_size, threads_num, [this, &fill_row](int begin, int end) {
+            auto row = std::vector<float>(std::is_same<T, float>::value ? 0 : matrix_size);
+            for(auto i = begin; i < end; i++) {
+                fill_row(i, row);
             }
+        });
+
+    }
 
-            costs_matrix[i][j] = costs_matrix[i][j];
-            costs_matrix[j][i] = costs_matrix[i][j];
+}
+
+namespace {
 
+    // number of bits used to quantize each coordinate before computing its position along a curve
+    constexpr auto CURVE_ORDER = 16u;
+
+    /**
+     * Returns the position of a point along a Hilbert curve filling the 2^CURVE_ORDER x 2^CURVE_ORDER grid.
+     */
+    uint64_t get_hilbert_index(uint32_t x, uint32_t y) {
+        const auto side = 1u << CURVE_ORDER;
+        auto index = uint64_t(0);
+        for(auto s = side / 2; s > 0; s /= 2) {
+            const auto rx = (x & s) != 0 ? 1u : 0u;
+            const auto ry = (y & s) != 0 ? 1u : 0u;
+            index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // rotate the quadrant so that the curve is continuous
+            if(ry == 0) {
+                if(rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
         }
+        return index;
+    }
+
+    /**
+     * Returns the position of a point along a Morton curve, i.e. the interleaving of the coordinates bits.
+     */
+    uint64_t get_morton_index(uint32_t x, uint32_t y) {
+        const auto spread = [](uint64_t v) {
+            v = (v | (v << 16u)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8u)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4u)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2u)) & 0x3333333333333333ull;
+            v = (v | (v << 1u)) & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1u);
     }
 
-    neighbors.resize(matrix_size);
+}
+
+void Instance::renumber_vertices(VerticesOrdering ordering) {
 
-    auto all_vertices = std::vector<int>(matrix_size);
+    const auto vertices_num = static_cast<size_t>(matrix_size);
 
-    for(auto i = 0; i < matrix_size; i++) {
-        all_vertices[i] = i;
+    auto min_x = std::numeric_limits<float>::max(), max_x = std::numeric_limits<float>::lowest();
+    auto min_y = min_x, max_y = max_x;
+    for(auto i = 0ul; i < vertices_num; i++) {
+        min_x = std::min(min_x, x_coordinates[i]);
+        max_x = std::max(max_x, x_coordinates[i]);
+        min_y = std::min(min_y, y_coordinates[i]);
+        max_y = std::max(max_y, y_coordinates[i]);
     }
 
-    for(auto i = 0; i < matrix_size; i++) {
+    // both axes share the same scale to preserve the proximity of the points
+    const auto extent = static_cast<double>(std::max(max_x - min_x, max_y - min_y));
+    const auto scale = extent > 0.0 ? ((1u << CURVE_ORDER) - 1) / extent : 0.0;
 
-        std::sort(all_vertices.begin(), all_vertices.end(), [this, i](auto j, auto k){ return costs_matrix[i][j] < costs_matrix[i][k];});
+    // the depot keeps index 0, customers are sorted by curve position and then by original index
+    auto keys = std::vector<std::pair<uint64_t, int>>();
+    keys.reserve(vertices_num - 1);
+    for(auto i = 1; i < matrix_size; i++) {
+        const auto x = static_cast<uint32_t>((x_coordinates[i] - min_x) * scale);
+        const auto y = static_cast<uint32_t>((y_coordinates[i] - min_y) * scale);
+        keys.emplace_back(ordering == VerticesOrdering::Hilbert ? get_hilbert_index(x, y) : get_morton_index(x, y), i);
+    }
+    std::sort(keys.begin(), keys.end());
 
-        neighbors[i] = all_vertices;
+    external_ids.resize(vertices_num);
+    internal_ids.resize(vertices_num);
+    external_ids[0] = 0;
+    for(auto i = 1ul; i < vertices_num; i++) {
+        external_ids[i] = keys[i - 1].second;
+    }
+    for(auto i = 0ul; i < vertices_num; i++) {
+        internal_ids[external_ids[i]] = static_cast<int>(i);
+    }
+    external_ids_ptr = external_ids.data();
 
-        // ensure that the first vertex is i
-        if(neighbors[i][0] != i) {
-            auto n = 1;
-            while(n < matrix_size) {
-                if(neighbors[i][n] == i) {
-                    break;
-                }
-                n++;
+    const auto permute = [this, vertices_num](auto &values) {
+        auto permuted = values;
+        for(auto i = 0ul; i < vertices_num; i++) {
+            permuted[i] = values[external_ids[i]];
+        }
+        values.swap(permuted);
+    };
+    permute(x_coordinates);
+    permute(y_coordinates);
+    permute(demands);
+
+}
+
+void Instance::initialize_data_structures() {
+
+    depot = 0;
+    customers_num = matrix_size - 1;
+    customers_begin = 1;
+    customers_end = matrix_size;
+
+    x_coordinates_ptr = x_coordinates.data();
+    y_coordinates_ptr = y_coordinates.data();
+    demands_ptr = demands.data();
+
+    if(costs_storage != CostsStorage::OnTheFly) {
+
+        if(costs_format != CostsFormat::Float) {
+            // no cost can exceed the diagonal of the bounding box
+            const auto x_range = std::minmax_element(x_coordinates.begin(), x_coordinates.end());
+            const auto y_range = std::minmax_element(y_coordinates.begin(), y_coordinates.end());
+            const auto max_cost = euclidean_cost(*x_range.first, *y_range.first, *x_range.second, *y_range.second, true);
+            if(max_cost + 1.0f <= std::numeric_limits<uint16_t>::max()) {
+                costs_format = CostsFormat::UInt16;
             }
-            std::swap(neighbors[i][0], neighbors[i][n]);
         }
 
-        assert(neighbors[i][0] == i);
+        // every element is written by fill_costs_matrix, hence the memory is not cleared
+        auto allocation = mm::AllocationOptions();
+        allocation.page_size = huge_pages ? mm::PageSize::Huge : mm::PageSize::Default;
+        allocation.numa_policy = numa_interleave ? mm::NumaPolicy::Interleave : mm::NumaPolicy::Default;
+        allocation.zeroed = false;
+
+        const auto columns = static_cast<size_t>(matrix_size);
+
+        switch(costs_format) {
+            case CostsFormat::UInt16: {
+                costs_stride = padded_rows ? mm::get_padded_row_size<uint16_t>(columns) : columns;
+                const auto costs = mm::request_aligned_memory<uint16_t>(get_costs_elements(), allocation);
+                costs_memory.reset(costs);
+                fill_costs_matrix(costs);
+                uint16_costs = costs;
+                break;
+            }
+            case CostsFormat::Int32: {
+                costs_stride = padded_rows ? mm::get_padded_row_size<int32_t>(columns) : columns;
+                const auto costs = mm::request_aligned_memory<int32_t>(get_costs_elements(), allocation);
+                costs_memory.reset(costs);
+                fill_costs_matrix(costs);
+                int32_costs = costs;
+                break;
+            }
+            default: {
+                costs_stride = padded_rows ? mm::get_padded_row_size<float>(columns) : columns;
+                const auto costs = mm::request_aligned_memory<float>(get_costs_elements(), allocation);
+                costs_memory.reset(costs);
+                fill_costs_matrix(costs);
+                float_costs = costs;
+                break;
+            }
+        }
 
     }
 
+    resolve_costs_layout();
+
+    spatial_index = KdTree(x_coordinates_ptr, y_coordinates_ptr, matrix_size);
+
+    neighbors_num = std::max(1, std::min(neighbors_num, matrix_size));
+    neighbors.resize(static_cast<size_t>(matrix_size) * neighbors_num);
+    neighbors_ptr = neighbors.data();
+
+    build_neighbors(spatial_index, x_coordinates_ptr, y_coordinates_ptr, neighbors_num,
+                    [this](int i, int j) { return Instance::get_cost(i, j); }, neighbors.data(), threads_num);
+
     for(auto i = customers_begin; i < customers_end; i++) {
         if(get_demand(i) == 0) {
             std::cerr << "[::ERROR::] Malformed instance: customer " << i << " load is 0.\n";
@@ -7,39 +7,362 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <cfloat>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include "AbstractInstance.hpp"
+#include "CostsKernel.hpp"
+#include "KdTree.hpp"
 
 /**
- * Basic implementation of InstanceInterface.
+ * Basic implementation of InstanceInterface. The class is final, calls through an Instance reference are thus
+ * statically dispatched.
  */
-class Instance : public AbstractInstance {
+class Instance final : public AbstractInstance {
+
+public:
+
+    /**
+     * Defines how the edge costs returned by get_cost are made available.
+     */
+    enum class CostsStorage {
+        /**
+         * The costs are computed once and stored in a full vertices_num x vertices_num matrix.
+         */
+        Matrix,
+        /**
+         * Since costs are symmetric, only the lower triangular part of the matrix, diagonal included, is stored. It
+         * halves the memory usage at the price of a slightly more expensive index computation.
+         */
+        TriangularMatrix,
+        /**
+         * No matrix is allocated and each cost is computed from the coordinates whenever it is requested. It is the
+         * only viable option for very large instances whose matrix would not fit in memory.
+         */
+        OnTheFly
+    };
+
+    /**
+     * Defines how the vertices of a text file are numbered.
+     */
+    enum class VerticesOrdering {
+        /**
+         * Vertices keep the order of the file.
+         */
+        File,
+        /**
+         * Customers are sorted along a Hilbert curve over the coordinates bounding box, so that close customers get
+         * close indices and data indexed by vertex is accessed with a better locality.
+         */
+        Hilbert,
+        /**
+         * Same as Hilbert, with a Morton (Z-order) curve which is cheaper to compute but has a slightly worse locality.
+         */
+        Morton
+    };
+
+    /**
+     * Settings used to build an Instance.
+     */
+    struct Options {
+        /**
+         * Whether the euclidean costs are rounded to the nearest integer.
+         */
+        bool round_costs = true;
+        /**
+         * How the costs are stored.
+         */
+        CostsStorage costs_storage = CostsStorage::Matrix;
+        /**
+         * Number of nearest neighbors stored for each vertex, including the vertex itself. Values larger than the
+         * number of vertices keep all of them.
+         */
+        int neighbors_num = std::numeric_limits<int>::max();
+        /**
+         * Number of threads used to build the cost matrix and the neighbors lists, values smaller than one select
+         * all the available hardware threads. The resulting instance does not depend on it.
+         */
+        int threads_num = 1;
+        /**
+         * Whether the matrix stores the rounded costs as integers, using 16 bits when the largest cost fits in them
+         * and 32 bits otherwise. It halves or quarters the memory traffic of cost lookups. Ignored when the costs
+         * are not rounded.
+         */
+        bool integer_costs = false;
+        /**
+         * How the vertices are numbered, the depot is always vertex 0. When the customers are renumbered,
+         * get_external_id and get_internal_id translate between the file identifiers and the vertices.
+         */
+        VerticesOrdering vertices_ordering = VerticesOrdering::File;
+        /**
+         * Whether the cost matrix is backed by 2 MB pages, which removes most of the TLB misses of random lookups
+         * in large matrices. Reserved huge pages are used when available, transparent ones otherwise.
+         */
+        bool huge_pages = false;
+        /**
+         * Whether the rows of a full cost matrix are padded to a multiple of 64 bytes, so that each row starts on
+         * its own cache line. The matrix then takes slightly more memory.
+         */
+        bool padded_rows = false;
+        /**
+         * Whether the pages of the cost matrix are interleaved over all the NUMA nodes, so that threads of a solver
+         * sharing the instance across several sockets share the bandwidth of all the memory controllers instead
+         * of reading the matrix from the node that built it. It has no effect on single node systems.
+         */
+        bool numa_interleave = false;
+        /**
+         * Whether the path names a POSIX shared memory object created by AbstractInstance::share instead of a file.
+         * The object is attached read-only and its pages are shared with all the processes attaching it, the other
+         * options are ignored.
+         */
+        bool shared_memory = false;
+    };
+
+    /**
+     * Cost lookups over a full matrix of T elements whose rows start every stride elements. Each lookup is a single
+     * load without any dispatch.
+     */
+    template<class T>
+    class MatrixCosts {
+
+        const T* costs;
+        size_t stride;
+
+    public:
+
+        MatrixCosts(const T* costs_, size_t stride_) : costs(costs_), stride(stride_) { }
+
+        inline float get_cost(int i, int j) const {
+            return static_cast<float>(costs[static_cast<size_t>(i) * stride + static_cast<size_t>(j)]);
+        }
+
+        inline int get_integer_cost(int i, int j) const {
+            return static_cast<int>(costs[static_cast<size_t>(i) * stride + static_cast<size_t>(j)]);
+        }
+
+    };
+
+    /**
+     * Cost lookups over the row-major lower triangle of a matrix of T elements, diagonal included. The min and max
+     * of the index computation are compiled into conditional moves, each lookup is thus free of branches.
+     */
+    template<class T>
+    class TriangularMatrixCosts {
+
+        const T* costs;
+
+        static inline size_t get_index(int i, int j) {
+            const auto row = static_cast<size_t>(std::max(i, j));
+            const auto column = static_cast<size_t>(std::min(i, j));
+            return row * (row + 1) / 2 + column;
+        }
+
+    public:
+
+        explicit TriangularMatrixCosts(const T* costs_) : costs(costs_) { }
+
+        inline float get_cost(int i, int j) const {
+            return static_cast<float>(costs[get_index(i, j)]);
+        }
+
+        inline int get_integer_cost(int i, int j) const {
+            return static_cast<int>(costs[get_index(i, j)]);
+        }
+
+    };
+
+    /**
+     * Cost lookups computing each cost from the coordinates.
+     */
+    class OnTheFlyCosts {
+
+        const float* x_coordinates;
+        const float* y_coordinates;
+        bool round_costs;
+
+    public:
+
+        OnTheFlyCosts(const float* x_coordinates_, const float* y_coordinates_, bool round_costs_) :
+                x_coordinates(x_coordinates_), y_coordinates(y_coordinates_), round_costs(round_costs_) { }
+
+        inline float get_cost(int i, int j) const {
+            return euclidean_cost(x_coordinates[i], y_coordinates[i], x_coordinates[j], y_coordinates[j], round_costs);
+        }
+
+        inline int get_integer_cost(int i, int j) const {
+            return static_cast<int>(get_cost(i, j));
+        }
+
+    };
+
+private:
+
+    enum class CostsFormat {
+        Float,
+        Int32,
+        UInt16
+    };
+
+    // storage and format combined once the costs are available, so that lookups dispatch on a single value
+    enum class CostsLayout {
+        FloatMatrix,
+        Int32Matrix,
+        UInt16Matrix,
+        FloatTriangularMatrix,
+        Int32TriangularMatrix,
+        UInt16TriangularMatrix,
+        OnTheFly
+    };
 
     bool valid = false;
 
     int matrix_size = 0;
     int capacity = 0;
+    // filled by the text parsers, accessed through the pointers below
     std::vector<float> x_coordinates;
     std::vector<float> y_coordinates;
     std::vector<int> demands;
+    // views either over the vectors or over a memory-mapped binary file
+    const float* x_coordinates_ptr = nullptr;
+    const float* y_coordinates_ptr = nullptr;
+    const int* demands_ptr = nullptr;
+    const Neighbor* neighbors_ptr = nullptr;
+    // empty, respectively null, when the vertices follow the file order
+    std::vector<int> external_ids;
+    std::vector<int> internal_ids;
+    const int* external_ids_ptr = nullptr;
+    // owners of the memory the views point into when it is not held by a vector, so that moves keep the views valid
+    struct MappedMemoryRelease {
+        size_t size;
+        MappedMemoryRelease() : size(0) { }
+        explicit MappedMemoryRelease(size_t size_) : size(size_) { }
+        void operator()(void* memory) const;
+    };
+    struct AlignedMemoryRelease {
+        void operator()(void* memory) const;
+    };
+    std::unique_ptr<void, MappedMemoryRelease> mapped_memory;
+    std::unique_ptr<void, AlignedMemoryRelease> costs_memory;
     int depot = 0;
     int customers_num = 0;
     int customers_begin = 0;
     int customers_end = 0;
-    float** costs_matrix = nullptr;
-    std::vector<std::vector<int>> neighbors;
+    bool round_costs = true;
+    CostsStorage costs_storage = CostsStorage::Matrix;
+    int threads_num = 1;
+    bool huge_pages = false;
+    bool padded_rows = false;
+    bool numa_interleave = false;
+    CostsFormat costs_format = CostsFormat::Float;
+    CostsLayout costs_layout = CostsLayout::OnTheFly;
+    size_t costs_stride = 0;
+    // views either over costs_memory or over a memory-mapped binary file
+    const float* float_costs = nullptr;
+    const int32_t* int32_costs = nullptr;
+    const uint16_t* uint16_costs = nullptr;
+    int neighbors_num = 0;
+    std::vector<Neighbor> neighbors;
+    KdTree spatial_index;
 
-    bool parse_golden_instance(const std::string& string);
-    bool parse_x_instance(const std::string& string);
-    bool parse_zachariadis_kironoudis_instance(const std::string& string);
-    void initialize_data_structures(bool b);
+    bool parse_text_instance(const std::string& path);
+    bool parse_golden_instance(const char* begin, const char* end);
+    bool parse_x_instance(const char* begin, const char* end);
+    bool parse_zachariadis_kironoudis_instance(const char* begin, const char* end);
+    bool map_binary_instance(const std::string& path, bool& is_binary);
+    bool map_binary_descriptor(int descriptor, const std::string& path, bool& is_binary);
+    bool attach_shared_memory(const std::string& name);
+    void renumber_vertices(VerticesOrdering ordering);
+    void initialize_data_structures();
+    void resolve_costs_layout();
+
+    template<class T>
+    void fill_costs_matrix(T *costs);
+
+    inline size_t get_cost_index(int i, int j) const {
+        if(costs_storage == CostsStorage::TriangularMatrix) {
+            // row-major lower triangle, min and max are compiled into conditional moves
+            const auto row = static_cast<size_t>(std::max(i, j));
+            const auto column = static_cast<size_t>(std::min(i, j));
+            return row * (row + 1) / 2 + column;
+        }
+        return static_cast<size_t>(i) * costs_stride + static_cast<size_t>(j);
+    }
+
+    size_t get_costs_elements() const;
 
 public:
 
     explicit Instance(const std::string& path, bool round_costs = true);
 
+    /**
+     * Builds the instance stored in the given file. When the file has been written by serialize with a binary
+     * format, it is memory-mapped and its content is used without copies, so that processes loading the same file
+     * share its pages. In such a case the options are ignored and the costs, their rounding and the neighbors lists
+     * are the stored ones.
+     * @param path instance file
+     * @param options construction settings
+     */
+    Instance(const std::string& path, const Options& options);
+
     virtual ~Instance();
 
+    // copies would share the views and the owned memory of the source
+    Instance(const Instance&) = delete;
+    Instance& operator=(const Instance&) = delete;
+
+    /**
+     * Builds an instance by taking over the data of a source instance, which can afterwards only be destroyed or
+     * assigned.
+     * @param source instance
+     */
+    Instance(Instance&& source) noexcept = default;
+
+    /**
+     * Releases the data of the instance and takes over the data of a source instance, which can afterwards only be
+     * destroyed or assigned.
+     * @param source instance
+     * @return this instance
+     */
+    Instance& operator=(Instance&& source) noexcept = default;
+
+    /**
+     * Calls function with the lookups matching how the costs are stored and returns its result. These are a
+     * MatrixCosts<T> or a TriangularMatrixCosts<T>, with T being float, int32_t or uint16_t, or an OnTheFlyCosts.
+     * The layout is resolved when the instance is built, hence a loop written in a generic lambda is compiled once
+     * per layout and runs without any dispatch, e.g.
+     * instance.visit_costs([&](const auto& costs) { for(...) { total += costs.get_integer_cost(i, j); } });
+     * get_cost and get_integer_cost go through it on each call, the default full float matrix is tested first so that
+     * its lookups only pay one comparison against a value which never changes.
+     * @param function callable accepting any of the lookup classes and returning the same type for all of them
+     * @return value returned by function
+     */
+    template<class Function>
+    inline auto visit_costs(const Function& function) const -> decltype(function(MatrixCosts<float>(nullptr, 0))) {
+        // a chain of comparisons rather than a switch, which would be compiled into an indirect jump
+        if(costs_layout == CostsLayout::FloatMatrix) {
+            return function(MatrixCosts<float>(float_costs, costs_stride));
+        }
+        if(costs_layout == CostsLayout::UInt16Matrix) {
+            return function(MatrixCosts<uint16_t>(uint16_costs, costs_stride));
+        }
+        if(costs_layout == CostsLayout::Int32Matrix) {
+            return function(MatrixCosts<int32_t>(int32_costs, costs_stride));
+        }
+        if(costs_layout == CostsLayout::FloatTriangularMatrix) {
+            return function(TriangularMatrixCosts<float>(float_costs));
+        }
+        if(costs_layout == CostsLayout::UInt16TriangularMatrix) {
+            return function(TriangularMatrixCosts<uint16_t>(uint16_costs));
+        }
+        if(costs_layout == CostsLayout::Int32TriangularMatrix) {
+            return function(TriangularMatrixCosts<int32_t>(int32_costs));
+        }
+        return function(OnTheFlyCosts(x_coordinates_ptr, y_coordinates_ptr, round_costs));
+    }
+
     inline bool is_valid() const override {return valid; }
 
     inline int get_depot() const override { return 0; }
@@ -58,15 +381,60 @@ public:
 
     inline int get_vertices_end() const override {return matrix_size; }
 
-    inline float get_cost(int i, int j) const override { return costs_matrix[i][j]; }
+    inline float get_cost(int i, int j) const override {
+        return visit_costs([i, j](const auto& costs) { return costs.get_cost(i, j); });
+    }
+
+    inline bool has_integer_costs() const override { return round_costs; }
+
+    inline int get_integer_cost(int i, int j) const override {
+        return visit_costs([i, j](const auto& costs) { return costs.get_integer_cost(i, j); });
+    }
+
+    /**
+     * Returns the number of bytes used to store the costs.
+     * @return memory used by the costs
+     */
+    size_t get_costs_memory_usage() const;
+
+    inline CostsStorage get_costs_storage() const { return costs_storage; }
+
+    /**
+     * Returns whether the instance has been loaded from a memory-mapped binary file.
+     * @return true if the instance is memory-mapped, false otherwise
+     */
+    inline bool is_memory_mapped() const { return mapped_memory != nullptr; }
+
+    inline int get_demand(int i) const override { return demands_ptr[i]; }
+
+    inline NeighborsView get_neighbors_of(int i) const override {
+        return NeighborsView(&neighbors_ptr[static_cast<size_t>(i) * neighbors_num], static_cast<size_t>(neighbors_num));
+    }
+
+    inline NeighborsSpan get_neighbor_entries_of(int i) const override {
+        return NeighborsSpan(&neighbors_ptr[static_cast<size_t>(i) * neighbors_num], static_cast<size_t>(neighbors_num));
+    }
+
+    inline int get_external_id(int i) const override { return external_ids_ptr ? external_ids_ptr[i] : i; }
+
+    inline int get_internal_id(int external_id) const override {
+        if(internal_ids.empty() || external_id < 0 || external_id >= matrix_size) {
+            return external_id;
+        }
+        return internal_ids[external_id];
+    }
 
-    inline int get_demand(int i) const override { return demands[i]; }
+    inline float get_x_coordinate(int vertex) const override { return x_coordinates_ptr[vertex]; }
 
-    inline std::vector<int>& get_neighbors_of(int i) override { return neighbors[i]; }
+    inline float get_y_coordinate(int vertex) const override { return y_coordinates_ptr[vertex]; }
 
-    inline float get_x_coordinate(int vertex) const override { return x_coordinates[vertex]; }
+    inline void get_nearest_vertices(float x, float y, int k, std::vector<int>& vertices) const override {
+        spatial_index.get_nearest(x, y, k, vertices);
+    }
 
-    inline float get_y_coordinate(int vertex) const override { return y_coordinates[vertex]; }
+    inline void get_vertices_within_radius(float x, float y, float radius, std::vector<int>& vertices) const override {
+        spatial_index.get_within_radius(x, y, radius, vertices);
+    }
 
 };
 
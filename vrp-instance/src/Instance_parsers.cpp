@@ -4,258 +4,408 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <cerrno>
+#include <cfloat>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
 #include "Instance.hpp"
 
+namespace {
 
-bool Instance::parse_golden_instance(const std::string& path) {
+    /**
+     * Cursor over a text buffer which reproduces the getline, stoi and stof based parsing without any allocation.
+     * Tokens are read from the current line only, skipping the blanks in front of them, and a missing or malformed
+     * token makes the read fail. The buffer must be null-terminated.
+     */
+    class TextCursor {
 
-    try {
+        const char *next;
+        const char *end;
+        const char *position = nullptr;
+        const char *line_end = nullptr;
 
-        std::ifstream stream(path);
-
-        if (!stream) {
-            throw std::exception();
+        static inline bool is_blank(char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
         }
 
-        std::string line;
-        std::string::size_type sz = 0;
-
-        // skip 3 lines
-        std::getline(stream, line);
-        std::getline(stream, line);
-        std::getline(stream, line);
-
-        // dimension
-        std::getline(stream, line);
-        std::stringstream ss(line);
-        std::getline(ss, line, ':');
-        std::getline(ss, line, '\n');
-        matrix_size = stoi(line, &sz);
-        line.erase(0, sz);
-
-        // capacity
-        std::getline(stream, line);
-        std::stringstream ss2(line);
-        std::getline(ss2, line, ':');
-        std::getline(ss2, line, '\n');
-        capacity = stoi(line, &sz);
-        line.erase(0, sz);
-
-        // vehicles
-        std::getline(stream, line);
-
-        // skip 4 lines
-        std::getline(stream, line);
-        std::getline(stream, line);
-        std::getline(stream, line);
-        std::getline(stream, line);
-
-        x_coordinates.resize(matrix_size);
-        y_coordinates.resize(matrix_size);
-        demands.resize(matrix_size);
+        static inline bool is_digit(char c) {
+            return c >= '0' && c <= '9';
+        }
 
-        // coord section
-        // reserve index 0 for the depot (it is not define in this section)
-        for (auto n = 1; n < matrix_size; n++) {
+        inline void skip_blanks() {
+            while (position < line_end && is_blank(*position)) {
+                position++;
+            }
+        }
 
-            std::getline(stream, line);
+        // strtod-like parsing, used for the tokens the fast path does not handle
+        bool read_float_slow(float &value) {
+            char *token_end = nullptr;
+            errno = 0;
+            value = std::strtof(position, &token_end);
+            if (token_end == position || token_end > line_end || errno == ERANGE) {
+                return false;
+            }
+            position = token_end;
+            return true;
+        }
 
-            stoi(line, &sz);    // index
-            line.erase(0, sz);
+    public:
 
-            x_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
+        TextCursor(const char *begin, const char *end_) : next(begin), end(end_) { }
 
-            y_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
+        /**
+         * Moves to the next line, which is empty when the end of the buffer has been reached.
+         */
+        void next_line() {
+            position = next;
+            line_end = static_cast<const char *>(std::memchr(next, '\n', static_cast<size_t>(end - next)));
+            if (!line_end) {
+                line_end = end;
+            }
+            next = line_end < end ? line_end + 1 : end;
+        }
 
+        /**
+         * Moves the cursor after the first occurrence of c in the current line.
+         * @param c character to look for
+         * @return true if found, false otherwise
+         */
+        bool skip_past(char c) {
+            const auto found = static_cast<const char *>(std::memchr(position, c, static_cast<size_t>(line_end - position)));
+            if (!found) {
+                return false;
+            }
+            position = found + 1;
+            return true;
         }
 
-        // demand section
-        std::getline(stream, line);
-        // depot not in this section  too
-        for (auto n = 1; n < matrix_size; n++) {
+        /**
+         * Reads an integer with the same semantic as stoi, i.e. the token stops at the first non-digit character.
+         * @param value where the integer is stored
+         * @return true if an integer has been read, false otherwise
+         */
+        bool read_int(int &value) {
+            skip_blanks();
+            auto p = position;
+            const auto negative = p < line_end && *p == '-';
+            if (p < line_end && (*p == '-' || *p == '+')) {
+                p++;
+            }
+            const auto digits_begin = p;
+            auto magnitude = 0ll;
+            while (p < line_end && is_digit(*p)) {
+                magnitude = magnitude * 10 + (*p - '0');
+                if (magnitude > static_cast<long long>(INT_MAX) + 1) {
+                    return false;
+                }
+                p++;
+            }
+            if (p == digits_begin || (!negative && magnitude > INT_MAX)) {
+                return false;
+            }
+            value = static_cast<int>(negative ? -magnitude : magnitude);
+            position = p;
+            return true;
+        }
 
-            std::getline(stream, line);
+        /**
+         * Reads a float with the same result as stof. Plain decimal tokens are converted with a single correctly
+         * rounded double operation, which then gives the correctly rounded float unless the double lies exactly
+         * halfway between two floats. Such cases and any other syntax are handed to strtof.
+         * @param value where the float is stored
+         * @return true if a float has been read, false otherwise
+         */
+        bool read_float(float &value) {
+
+            static const double powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+                                                   1e13, 1e14, 1e15};
+
+            skip_blanks();
+            auto p = position;
+            const auto negative = p < line_end && *p == '-';
+            if (p < line_end && (*p == '-' || *p == '+')) {
+                p++;
+            }
+
+            auto mantissa = 0ull;
+            auto digits = 0;
+            auto fraction_digits = 0;
+            while (p < line_end && is_digit(*p)) {
+                mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                digits++;
+                p++;
+            }
+            if (p < line_end && *p == '.') {
+                p++;
+                while (p < line_end && is_digit(*p)) {
+                    mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+                    digits++;
+                    fraction_digits++;
+                    p++;
+                }
+            }
+
+            // exponents, hexadecimal values, infinities and long tokens
+            if (digits == 0 || digits > 15 || (p < line_end && (*p == 'e' || *p == 'E' || *p == 'x' || *p == 'X'))) {
+                return read_float_slow(value);
+            }
+
+            // at most 15 digits keep both operands exact, so the quotient is correctly rounded
+            const auto result = static_cast<double>(mantissa) / powers_of_ten[fraction_digits];
+            if (result != 0.0 && (result < FLT_MIN || result > FLT_MAX)) {
+                return read_float_slow(value);
+            }
+            auto bits = 0ull;
+            std::memcpy(&bits, &result, sizeof(bits));
+            if ((bits & ((1ull << 29u) - 1)) == (1ull << 28u)) {
+                return read_float_slow(value);
+            }
+
+            value = static_cast<float>(negative ? -result : result);
+            position = p;
+            return true;
 
-            stoi(line, &sz);        // index
-            line.erase(0, sz);
+        }
 
-            demands[n] = stoi(line, &sz);
-            line.erase(0, sz);
+    };
+
+    /**
+     * Text formats the parsers are able to read.
+     */
+    enum class TextFormat {
+        Golden,
+        X,
+        ZachariadisKironoudis
+    };
+
+    /**
+     * Detects the format from the first lines. Zachariadis and Kironoudis files start with the number of customers,
+     * while Golden files differ from X ones by having the capacity in the fifth line.
+     */
+    TextFormat detect_text_format(const char *begin, const char *end) {
+
+        auto cursor = TextCursor(begin, end);
+        auto value = 0;
+
+        cursor.next_line();
+        if (cursor.read_int(value)) {
+            return TextFormat::ZachariadisKironoudis;
+        }
 
+        for (auto n = 0; n < 4; n++) {
+            cursor.next_line();
         }
 
-        // depot section
-        std::getline(stream, line);
+        if (cursor.skip_past(':') && cursor.read_int(value)) {
+            return TextFormat::Golden;
+        }
 
-        std::getline(stream, line);
+        return TextFormat::X;
 
-        x_coordinates[0] = stof(line, &sz);
-        line.erase(0, sz);
+    }
 
-        y_coordinates[0] = stof(line, &sz);
-        line.erase(0, sz);
+}
 
-        demands[0] = 0;
+bool Instance::parse_text_instance(const std::string &path) {
 
-    } catch (std::exception &e) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
 
+    if (!stream) {
         return false;
-
     }
 
-    return true;
-}
-
-bool Instance::parse_x_instance(const std::string& path) {
-
-    try {
+    // directories can be opened as well, but report either a failure or a bogus size
+    const auto size = stream.tellg();
+    auto buffer = std::string();
+    if (size < 0 || static_cast<unsigned long long>(size) > buffer.max_size()) {
+        return false;
+    }
 
-        std::ifstream stream(path);
+    // a single read, the string also provides the null terminator strtof relies on
+    buffer.assign(static_cast<size_t>(size), '\0');
+    stream.seekg(0);
+    if (!stream.read(&buffer[0], static_cast<std::streamsize>(buffer.size()))) {
+        return false;
+    }
 
-        if(!stream) {
-            throw std::exception();
+    const auto begin = buffer.data();
+    const auto end = buffer.data() + buffer.size();
+
+    const auto parse = [this, begin, end](TextFormat format) {
+        switch (format) {
+            case TextFormat::ZachariadisKironoudis:
+                return parse_zachariadis_kironoudis_instance(begin, end);
+            case TextFormat::Golden:
+                return parse_golden_instance(begin, end);
+            default:
+                return parse_x_instance(begin, end);
         }
+    };
 
-        std::string line;
-        std::string::size_type sz = 0;
-
-        // skip 3 lines
-        std::getline(stream, line);
-        std::getline(stream, line);
-        std::getline(stream, line);
-
-        // dimension
-        std::getline(stream, line);
-        std::stringstream ss(line);
-        std::getline(ss, line, ':');
-        std::getline(ss, line, '\n');
-        matrix_size = stoi(line, &sz);
-        line.erase(0, sz);
-
-        // skip 1 line
-        std::getline(stream, line);
-
-        // capacity
-        std::getline(stream, line);
-        std::stringstream ss2(line);
-        std::getline(ss2, line, ':');
-        std::getline(ss2, line, '\n');
-        capacity = stoi(line, &sz);
-        line.erase(0, sz);
+    // the detected format is only a guess, the others are tried in turn when its parser rejects the file
+    const auto detected_format = detect_text_format(begin, end);
+    if (parse(detected_format)) {
+        return true;
+    }
+    for (auto format : {TextFormat::ZachariadisKironoudis, TextFormat::Golden, TextFormat::X}) {
+        if (format != detected_format && parse(format)) {
+            return true;
+        }
+    }
 
-        // skip 1 line
-        std::getline(stream, line);
+    return false;
 
-        x_coordinates.resize(matrix_size);
-        y_coordinates.resize(matrix_size);
-        demands.resize(matrix_size);
+}
 
-        // coord section
-        for (auto n = 0; n < matrix_size; n++) {
+bool Instance::parse_golden_instance(const char *begin, const char *end) {
 
-            std::getline(stream, line);
+    auto cursor = TextCursor(begin, end);
+    auto index = 0;
 
-            stoi(line, &sz);    // index
-            line.erase(0, sz);
+    // skip 3 lines
+    cursor.next_line();
+    cursor.next_line();
+    cursor.next_line();
 
-            x_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
+    // dimension
+    cursor.next_line();
+    if (!cursor.skip_past(':') || !cursor.read_int(matrix_size) || matrix_size < 1) {
+        return false;
+    }
 
-            y_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
+    // capacity
+    cursor.next_line();
+    if (!cursor.skip_past(':') || !cursor.read_int(capacity)) {
+        return false;
+    }
 
+    // vehicles
+    cursor.next_line();
+
+    // skip 4 lines
+    cursor.next_line();
+    cursor.next_line();
+    cursor.next_line();
+    cursor.next_line();
+
+    x_coordinates.resize(matrix_size);
+    y_coordinates.resize(matrix_size);
+    demands.resize(matrix_size);
+
+    // coord section
+    // reserve index 0 for the depot (it is not define in this section)
+    for (auto n = 1; n < matrix_size; n++) {
+        cursor.next_line();
+        if (!cursor.read_int(index) || !cursor.read_float(x_coordinates[n]) || !cursor.read_float(y_coordinates[n])) {
+            return false;
         }
+    }
 
-        // demand section
-        std::getline(stream, line);
-        for (auto n = 0; n < matrix_size; n++) {
-
-            std::getline(stream, line);
-
-            stoi(line, &sz);        // index
-            line.erase(0, sz);
-
-            demands[n] = stoi(line, &sz);
-            line.erase(0, sz);
-
+    // demand section
+    cursor.next_line();
+    // depot not in this section  too
+    for (auto n = 1; n < matrix_size; n++) {
+        cursor.next_line();
+        if (!cursor.read_int(index) || !cursor.read_int(demands[n])) {
+            return false;
         }
+    }
 
+    // depot section
+    cursor.next_line();
 
-    } catch (std::exception& e) {
+    cursor.next_line();
+    if (!cursor.read_float(x_coordinates[0]) || !cursor.read_float(y_coordinates[0])) {
         return false;
     }
 
-    return true;
+    demands[0] = 0;
 
+    return true;
 }
 
-bool Instance::parse_zachariadis_kironoudis_instance(const std::string& path) {
+bool Instance::parse_x_instance(const char *begin, const char *end) {
 
-    try {
+    auto cursor = TextCursor(begin, end);
+    auto index = 0;
 
-        std::ifstream stream(path);
+    // skip 3 lines
+    cursor.next_line();
+    cursor.next_line();
+    cursor.next_line();
 
-        if (!stream) {
-            throw std::exception();
-        }
-
-        std::string line;
-        std::string::size_type sz = 0;
+    // dimension
+    cursor.next_line();
+    if (!cursor.skip_past(':') || !cursor.read_int(matrix_size) || matrix_size < 1) {
+        return false;
+    }
 
-        // number of customers \t capacity \t route-lenght limit (optional)
-        std::getline(stream, line);
-        std::stringstream ss(line);
+    // skip 1 line
+    cursor.next_line();
 
-        std::getline(ss, line);
-        matrix_size = stoi(line, &sz) + 1;
-        line.erase(0, sz);
+    // capacity
+    cursor.next_line();
+    if (!cursor.skip_past(':') || !cursor.read_int(capacity)) {
+        return false;
+    }
 
-        capacity = static_cast<int>(stof(line, &sz));
-        line.erase(0, sz);
+    // skip 1 line
+    cursor.next_line();
 
+    x_coordinates.resize(matrix_size);
+    y_coordinates.resize(matrix_size);
+    demands.resize(matrix_size);
 
-        try {
-            stof(line, &sz);
-            line.erase(0, sz);
-        } catch (std::exception& e) {
+    // coord section
+    for (auto n = 0; n < matrix_size; n++) {
+        cursor.next_line();
+        if (!cursor.read_int(index) || !cursor.read_float(x_coordinates[n]) || !cursor.read_float(y_coordinates[n])) {
+            return false;
         }
+    }
 
+    // demand section
+    cursor.next_line();
+    for (auto n = 0; n < matrix_size; n++) {
+        cursor.next_line();
+        if (!cursor.read_int(index) || !cursor.read_int(demands[n])) {
+            return false;
+        }
+    }
 
+    return true;
 
+}
 
-        x_coordinates.resize(matrix_size);
-        y_coordinates.resize(matrix_size);
-        demands.resize(matrix_size);
-
-        for (auto n = 0; n < matrix_size; n++) {
-
-            std::getline(stream, line);
-
-            stoi(line, &sz);    // index
-            line.erase(0, sz);
-
-            x_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
-
-            y_coordinates[n] = stof(line, &sz);
-            line.erase(0, sz);
-
-            demands[n] = stoi(line, &sz);
-            line.erase(0, sz);
-
-        }
+bool Instance::parse_zachariadis_kironoudis_instance(const char *begin, const char *end) {
 
-    } catch (std::exception &e) {
+    auto cursor = TextCursor(begin, end);
+    auto index = 0;
+    auto value = 0.0f;
 
+    // number of customers \t capacity \t route-lenght limit (optional, ignored)
+    cursor.next_line();
+    if (!cursor.read_int(matrix_size) || matrix_size < 0 || matrix_size == INT_MAX || !cursor.read_float(value)) {
         return false;
-
+    }
+    matrix_size += 1;
+    capacity = static_cast<int>(value);
+
+    x_coordinates.resize(matrix_size);
+    y_coordinates.resize(matrix_size);
+    demands.resize(matrix_size);
+
+    for (auto n = 0; n < matrix_size; n++) {
+        cursor.next_line();
+        if (!cursor.read_int(index) || !cursor.read_float(x_coordinates[n]) || !cursor.read_float(y_coordinates[n]) ||
+            !cursor.read_int(demands[n])) {
+            return false;
+        }
     }
 
     return true;
 
 }
-
-
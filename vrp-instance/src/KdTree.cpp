@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <numeric>
+#include "KdTree.hpp"
+
+KdTree::KdTree(const float *x_coordinates, const float *y_coordinates, int points_num) {
+
+    assign(x_coordinates, y_coordinates, points_num);
+
+}
+
+void KdTree::assign(const float *x_coordinates, const float *y_coordinates, int points_num) {
+
+    index.resize(static_cast<size_t>(points_num));
+    std::iota(index.begin(), index.end(), 0);
+
+    split_on_y.resize(static_cast<size_t>(points_num));
+
+    // the indices are sorted by looking at the coordinates in the original order
+    build(0, points_num, x_coordinates, y_coordinates);
+
+    // which are then stored following the tree layout for a cache friendly traversal
+    x.resize(static_cast<size_t>(points_num));
+    y.resize(static_cast<size_t>(points_num));
+    for(auto n = 0; n < points_num; n++) {
+        x[n] = x_coordinates[index[n]];
+        y[n] = y_coordinates[index[n]];
+    }
+
+}
+
+void KdTree::build(int begin, int end, const float *x_coordinates, const float *y_coordinates) {
+
+    if(end - begin <= 1) {
+        return;
+    }
+
+    // split along the dimension with the largest extent
+    auto min_x = x_coordinates[index[begin]], max_x = min_x;
+    auto min_y = y_coordinates[index[begin]], max_y = min_y;
+    for(auto n = begin + 1; n < end; n++) {
+        min_x = std::min(min_x, x_coordinates[index[n]]);
+        max_x = std::max(max_x, x_coordinates[index[n]]);
+        min_y = std::min(min_y, y_coordinates[index[n]]);
+        max_y = std::max(max_y, y_coordinates[index[n]]);
+    }
+
+    const auto median = begin + (end - begin) / 2;
+    const auto split_y = max_y - min_y > max_x - min_x;
+    const auto coordinates = split_y ? y_coordinates : x_coordinates;
+
+    std::nth_element(index.begin() + begin, index.begin() + median, index.begin() + end, [coordinates](int i, int j) {
+        return coordinates[i] < coordinates[j] || (coordinates[i] == coordinates[j] && i < j);
+    });
+
+    split_on_y[median] = split_y;
+
+    build(begin, median, x_coordinates, y_coordinates);
+    build(median + 1, end, x_coordinates, y_coordinates);
+
+}
+
+void KdTree::search_nearest(int begin, int end, float qx, float qy, int k,
+                            std::vector<std::pair<float, int>> &heap) const {
+
+    if(begin >= end) {
+        return;
+    }
+
+    const auto median = begin + (end - begin) / 2;
+
+    const auto squared_distance = (qx - x[median]) * (qx - x[median]) + (qy - y[median]) * (qy - y[median]);
+    const auto candidate = std::make_pair(squared_distance, index[median]);
+
+    if(static_cast<int>(heap.size()) < k) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    } else if(candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    const auto difference = split_on_y[median] ? qy - y[median] : qx - x[median];
+
+    // points equal to the median along the split dimension may lie on both sides
+    if(difference < 0.0f) {
+        search_nearest(begin, median, qx, qy, k, heap);
+        if(static_cast<int>(heap.size()) < k || difference * difference <= heap.front().first) {
+            search_nearest(median + 1, end, qx, qy, k, heap);
+        }
+    } else {
+        search_nearest(median + 1, end, qx, qy, k, heap);
+        if(static_cast<int>(heap.size()) < k || difference * difference <= heap.front().first) {
+            search_nearest(begin, median, qx, qy, k, heap);
+        }
+    }
+
+}
+
+void KdTree::get_nearest(float qx, float qy, int k, std::vector<int> &points) const {
+
+    auto heap = std::vector<std::pair<float, int>>();
+
+    get_nearest(qx, qy, k, points, heap);
+
+}
+
+void KdTree::get_nearest(float qx, float qy, int k, std::vector<int> &points,
+                         std::vector<std::pair<float, int>> &heap) const {
+
+    points.clear();
+
+    if(k <= 0) {
+        return;
+    }
+
+    heap.clear();
+    heap.reserve(static_cast<size_t>(std::min(k, size())));
+
+    search_nearest(0, size(), qx, qy, k, heap);
+
+    std::sort_heap(heap.begin(), heap.end());
+
+    for(const auto &item : heap) {
+        points.push_back(item.second);
+    }
+
+}
+
+void KdTree::search_radius(int begin, int end, float qx, float qy, float squared_radius,
+                           std::vector<std::pair<float, int>> &found) const {
+
+    if(begin >= end) {
+        return;
+    }
+
+    const auto median = begin + (end - begin) / 2;
+
+    const auto squared_distance = (qx - x[median]) * (qx - x[median]) + (qy - y[median]) * (qy - y[median]);
+    if(squared_distance <= squared_radius) {
+        found.emplace_back(squared_distance, index[median]);
+    }
+
+    const auto difference = split_on_y[median] ? qy - y[median] : qx - x[median];
+
+    if(difference <= 0.0f || difference * difference <= squared_radius) {
+        search_radius(begin, median, qx, qy, squared_radius, found);
+    }
+    if(difference >= 0.0f || difference * difference <= squared_radius) {
+        search_radius(median + 1, end, qx, qy, squared_radius, found);
+    }
+
+}
+
+void KdTree::get_within_radius(float qx, float qy, float radius, std::vector<int> &points) const {
+
+    points.clear();
+
+    auto found = std::vector<std::pair<float, int>>();
+
+    search_radius(0, size(), qx, qy, radius * radius, found);
+
+    std::sort(found.begin(), found.end());
+
+    for(const auto &item : found) {
+        points.push_back(item.second);
+    }
+
+}
@@ -0,0 +1,81 @@
+#ifndef VRP_KDTREE_HPP
+#define VRP_KDTREE_HPP
+
+#include <vector>
+
+/**
+ * Static 2-dimensional k-d tree used to answer nearest neighbors and radius queries over a set of points in
+ * O(log n) expected time per query instead of scanning all of them. The tree is implicit: points are reordered so
+ * that the median of every range is the splitting node of that range, thus no pointers are stored.
+ * Distances are compared through their squared values and ties are broken by point index, making the results
+ * fully deterministic.
+ */
+class KdTree {
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<int> index;
+    std::vector<char> split_on_y;
+
+    void build(int begin, int end, const float *x_coordinates, const float *y_coordinates);
+    void search_nearest(int begin, int end, float qx, float qy, int k, std::vector<std::pair<float, int>> &heap) const;
+    void search_radius(int begin, int end, float qx, float qy, float squared_radius,
+                       std::vector<std::pair<float, int>> &found) const;
+
+public:
+
+    KdTree() = default;
+
+    /**
+     * Builds the tree in O(n log n) time.
+     * @param x_coordinates x-coordinates of the points
+     * @param y_coordinates y-coordinates of the points
+     * @param points_num number of points, which are identified by their index in [0, points_num)
+     */
+    KdTree(const float *x_coordinates, const float *y_coordinates, int points_num);
+
+    /**
+     * Rebuilds the tree over a new set of points in O(n log n) time, reusing the memory already allocated.
+     * @param x_coordinates x-coordinates of the points
+     * @param y_coordinates y-coordinates of the points
+     * @param points_num number of points, which are identified by their index in [0, points_num)
+     */
+    void assign(const float *x_coordinates, const float *y_coordinates, int points_num);
+
+    /**
+     * Returns the number of indexed points.
+     * @return number of points
+     */
+    inline int size() const { return static_cast<int>(index.size()); }
+
+    /**
+     * Retrieves the k points closest to (qx, qy) sorted by increasing distance.
+     * @param qx query x-coordinate
+     * @param qy query y-coordinate
+     * @param k number of points to retrieve, if larger than the number of points all of them are retrieved
+     * @param points where the point indices are stored, any previous content is cleared
+     */
+    void get_nearest(float qx, float qy, int k, std::vector<int> &points) const;
+
+    /**
+     * Same as get_nearest, but the search heap is provided by the caller and can be reused across queries.
+     * @param qx query x-coordinate
+     * @param qy query y-coordinate
+     * @param k number of points to retrieve, if larger than the number of points all of them are retrieved
+     * @param points where the point indices are stored, any previous content is cleared
+     * @param heap scratch array
+     */
+    void get_nearest(float qx, float qy, int k, std::vector<int> &points, std::vector<std::pair<float, int>> &heap) const;
+
+    /**
+     * Retrieves the points whose distance from (qx, qy) is at most radius sorted by increasing distance.
+     * @param qx query x-coordinate
+     * @param qy query y-coordinate
+     * @param radius query radius
+     * @param points where the point indices are stored, any previous content is cleared
+     */
+    void get_within_radius(float qx, float qy, float radius, std::vector<int> &points) const;
+
+};
+
+#endif //VRP_KDTREE_HPP
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cassert>
+#include "Neighbors.hpp"
+
+void select_neighbors(int vertex, const float *costs, int vertices_num, int neighbors_num,
+                      std::vector<int> &candidates, Neighbor *neighbors) {
+
+    assert(neighbors_num > 0 && neighbors_num <= vertices_num);
+
+    candidates.resize(static_cast<size_t>(vertices_num));
+    for(auto j = 0; j < vertices_num; j++) {
+        candidates[j] = j;
+    }
+
+    // vertex comes first, then increasing cost, then increasing index
+    const auto comparator = [vertex, costs](int j, int k) {
+        if(j == vertex || k == vertex) {
+            return j == vertex && k != vertex;
+        }
+        return costs[j] < costs[k] || (costs[j] == costs[k] && j < k);
+    };
+
+    const auto last = candidates.begin() + neighbors_num;
+
+    if(neighbors_num < vertices_num) {
+        std::nth_element(candidates.begin(), last - 1, candidates.end(), comparator);
+    }
+
+    std::sort(candidates.begin(), last, comparator);
+
+    for(auto n = 0; n < neighbors_num; n++) {
+        neighbors[n] = Neighbor{candidates[n], costs[candidates[n]]};
+    }
+
+    assert(neighbors[0].vertex == vertex);
+
+}
+
+void sort_neighbors(int vertex, int neighbors_num, std::vector<std::pair<float, int>> &candidates, Neighbor *neighbors) {
+
+    assert(neighbors_num > 0 && neighbors_num <= static_cast<int>(candidates.size()));
+
+    // vertex comes first, then increasing cost, then increasing index
+    const auto comparator = [vertex](const std::pair<float, int> &a, const std::pair<float, int> &b) {
+        if(a.second == vertex || b.second == vertex) {
+            return a.second == vertex && b.second != vertex;
+        }
+        return a < b;
+    };
+
+    if(std::find_if(candidates.begin(), candidates.end(), [vertex](const std::pair<float, int> &candidate) {
+        return candidate.second == vertex;
+    }) == candidates.end()) {
+        candidates.emplace_back(0.0f, vertex);
+    }
+
+    std::partial_sort(candidates.begin(), candidates.begin() + neighbors_num, candidates.end(), comparator);
+
+    for(auto n = 0; n < neighbors_num; n++) {
+        neighbors[n] = Neighbor{candidates[n].second, candidates[n].first};
+    }
+
+}
@@ -0,0 +1,274 @@
+#ifndef VRP_NEIGHBORS_HPP
+#define VRP_NEIGHBORS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "KdTree.hpp"
+#include "Parallel.hpp"
+
+/**
+ * Entry of a neighbors list. The cost from the vertex owning the list is stored next to the neighbor, so that scanning
+ * a granular neighborhood streams through a contiguous array instead of looking up the cost of each pair.
+ */
+struct Neighbor {
+    int vertex;
+    float cost;
+};
+
+static_assert(sizeof(Neighbor) == 8 && std::is_trivially_copyable<Neighbor>::value,
+              "neighbors entries are stored as raw bytes in binary instance files");
+
+/**
+ * Read-only view over the neighbors entries of a vertex. It does not own the data, which remains valid as long as the
+ * instance that generated the view is alive.
+ */
+class NeighborsSpan {
+
+    const Neighbor *first;
+    size_t length;
+
+public:
+
+    NeighborsSpan(const Neighbor *first_, size_t length_) : first(first_), length(length_) { }
+
+    inline const Neighbor *begin() const { return first; }
+
+    inline const Neighbor *end() const { return first + length; }
+
+    inline size_t size() const { return length; }
+
+    inline const Neighbor &operator[](size_t n) const { return first[n]; }
+
+};
+
+/**
+ * Read-only view over the neighbors of a vertex, which only exposes their indices. It does not own the data, which
+ * remains valid as long as the instance that generated the view is alive.
+ */
+class NeighborsView {
+
+    const Neighbor *first;
+    size_t length;
+
+public:
+
+    /**
+     * Random access iterator over the vertices of a neighbors list.
+     */
+    class iterator {
+
+        const Neighbor *entry = nullptr;
+
+    public:
+
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int *;
+        using reference = const int &;
+
+        iterator() = default;
+
+        explicit iterator(const Neighbor *entry_) : entry(entry_) { }
+
+        inline reference operator*() const { return entry->vertex; }
+
+        inline pointer operator->() const { return &entry->vertex; }
+
+        inline reference operator[](difference_type n) const { return entry[n].vertex; }
+
+        inline iterator &operator++() { ++entry; return *this; }
+
+        inline iterator operator++(int) { auto copy = *this; ++entry; return copy; }
+
+        inline iterator &operator--() { --entry; return *this; }
+
+        inline iterator operator--(int) { auto copy = *this; --entry; return copy; }
+
+        inline iterator &operator+=(difference_type n) { entry += n; return *this; }
+
+        inline iterator &operator-=(difference_type n) { entry -= n; return *this; }
+
+        inline iterator operator+(difference_type n) const { return iterator(entry + n); }
+
+        inline friend iterator operator+(difference_type n, const iterator &it) { return iterator(it.entry + n); }
+
+        inline iterator operator-(difference_type n) const { return iterator(entry - n); }
+
+        inline difference_type operator-(const iterator &other) const { return entry - other.entry; }
+
+        inline bool operator==(const iterator &other) const { return entry == other.entry; }
+
+        inline bool operator!=(const iterator &other) const { return entry != other.entry; }
+
+        inline bool operator<(const iterator &other) const { return entry < other.entry; }
+
+        inline bool operator>(const iterator &other) const { return entry > other.entry; }
+
+        inline bool operator<=(const iterator &other) const { return entry <= other.entry; }
+
+        inline bool operator>=(const iterator &other) const { return entry >= other.entry; }
+
+    };
+
+    NeighborsView(const Neighbor *first_, size_t length_) : first(first_), length(length_) { }
+
+    explicit NeighborsView(const NeighborsSpan &span) : first(span.begin()), length(span.size()) { }
+
+    inline iterator begin() const { return iterator(first); }
+
+    inline iterator end() const { return iterator(first + length); }
+
+    inline size_t size() const { return length; }
+
+    inline int operator[](size_t n) const { return first[n].vertex; }
+
+    /**
+     * Returns the same neighbors together with their costs.
+     * @return view over the neighbors entries
+     */
+    inline NeighborsSpan entries() const { return NeighborsSpan(first, length); }
+
+};
+
+/**
+ * Selects the neighbors_num vertices closest to vertex and stores them in neighbors sorted according to increasing
+ * cost. Ties are broken by vertex index and vertex itself is always placed in the first position, even when other
+ * vertices are at zero cost from it. The selection is partial, i.e. vertices beyond the first neighbors_num are not
+ * sorted.
+ * @param vertex vertex whose neighbors are selected
+ * @param costs costs from vertex to each vertex in [0, vertices_num)
+ * @param vertices_num number of vertices
+ * @param neighbors_num number of neighbors to select, at most vertices_num
+ * @param candidates scratch array, resized as needed
+ * @param neighbors array of at least neighbors_num elements where the neighbors and their costs are stored
+ */
+void select_neighbors(int vertex, const float *costs, int vertices_num, int neighbors_num,
+                      std::vector<int> &candidates, Neighbor *neighbors);
+
+/**
+ * Sorts the candidate neighbors of vertex according to increasing cost and stores the first neighbors_num of them in
+ * neighbors. Ties are broken by vertex index and vertex itself is always placed in the first position. If vertex is
+ * not among the candidates it is added at zero cost.
+ * @param vertex vertex whose neighbors are sorted
+ * @param neighbors_num number of neighbors to store, at most the number of candidates
+ * @param candidates pairs of cost from vertex and candidate neighbor, reordered by the function
+ * @param neighbors array of at least neighbors_num elements where the neighbors and their costs are stored
+ */
+void sort_neighbors(int vertex, int neighbors_num, std::vector<std::pair<float, int>> &candidates, Neighbor *neighbors);
+
+/**
+ * Scratch arrays used while building neighbors lists, they can be reused across calls to avoid allocations.
+ */
+struct NeighborsScratch {
+    std::vector<int> indices;
+    std::vector<float> costs;
+    std::vector<int> nearest;
+    std::vector<std::pair<float, int>> candidates;
+    std::vector<std::pair<float, int>> heap;
+};
+
+/**
+ * Builds the list of the neighbors_num nearest neighbors of a vertex. Short lists are obtained by querying a k-d tree
+ * built on the vertices coordinates, assuming costs to be non-decreasing with the euclidean distance, and then sorted
+ * by actual cost as in sort_neighbors. The query is widened until it retrieves all the vertices tied with the last
+ * neighbor cost, which happens with rounded costs, so that ties are broken by index among all of them. When the list
+ * covers a significant fraction of the vertices, a partial selection over all the costs from the vertex is cheaper and
+ * select_neighbors is used instead. Both strategies produce the same list, sorted by increasing cost with vertex first.
+ * @param vertex vertex whose list is built
+ * @param tree k-d tree built on the vertices coordinates
+ * @param x_coordinates vertices x-coordinates
+ * @param y_coordinates vertices y-coordinates
+ * @param neighbors_num number of neighbors, at most the number of vertices
+ * @param cost function returning the cost between two vertices
+ * @param scratch scratch arrays
+ * @param neighbors array of neighbors_num elements where the list is stored
+ */
+template<class CostFunction>
+void build_neighbors_of(int vertex, const KdTree &tree, const float *x_coordinates, const float *y_coordinates,
+                        int neighbors_num, const CostFunction &cost, NeighborsScratch &scratch, Neighbor *neighbors) {
+
+    const auto vertices_num = tree.size();
+
+    if(neighbors_num * 8 >= vertices_num) {
+
+        scratch.costs.resize(static_cast<size_t>(vertices_num));
+        for(auto j = 0; j < vertices_num; j++) {
+            scratch.costs[j] = cost(vertex, j);
+        }
+        select_neighbors(vertex, scratch.costs.data(), vertices_num, neighbors_num, scratch.indices, neighbors);
+
+    } else {
+
+        // one more point than needed, so that the farthest one usually proves that no tie was left out
+        auto nearest_num = std::min(neighbors_num + 1, vertices_num);
+
+        while(true) {
+
+            tree.get_nearest(x_coordinates[vertex], y_coordinates[vertex], nearest_num, scratch.nearest, scratch.heap);
+
+            scratch.candidates.clear();
+            for(auto j : scratch.nearest) {
+                scratch.candidates.emplace_back(cost(vertex, j), j);
+            }
+
+            if(nearest_num == vertices_num) {
+                break;
+            }
+
+            // the vertices not retrieved cost at least as much as the farthest retrieved one, thus they are not needed
+            // when enough vertices are strictly cheaper than it
+            const auto farthest_cost = scratch.candidates.back().first;
+            auto cheaper_num = 0;
+            for(const auto &candidate : scratch.candidates) {
+                if(candidate.second != vertex && candidate.first < farthest_cost) {
+                    cheaper_num++;
+                }
+            }
+            if(cheaper_num >= neighbors_num - 1) {
+                break;
+            }
+
+            nearest_num = std::min(2 * nearest_num, vertices_num);
+
+        }
+
+        sort_neighbors(vertex, neighbors_num, scratch.candidates, neighbors);
+
+    }
+
+}
+
+/**
+ * Builds the lists of the neighbors_num nearest neighbors of all the vertices as in build_neighbors_of. The vertices
+ * are split among threads_num threads, the lists do not depend on it.
+ * @param tree k-d tree built on the vertices coordinates
+ * @param x_coordinates vertices x-coordinates
+ * @param y_coordinates vertices y-coordinates
+ * @param neighbors_num number of neighbors of each vertex, at most the number of vertices
+ * @param cost thread-safe function returning the cost between two vertices
+ * @param neighbors array of tree.size() * neighbors_num elements where the lists are stored one after the other
+ * @param threads_num number of threads
+ */
+template<class CostFunction>
+void build_neighbors(const KdTree &tree, const float *x_coordinates, const float *y_coordinates, int neighbors_num,
+                     const CostFunction &cost, Neighbor *neighbors, int threads_num = 1) {
+
+    parallel_for(0, tree.size(), threads_num, [&](int begin, int end) {
+
+        auto scratch = NeighborsScratch();
+
+        for(auto i = begin; i < end; i++) {
+            build_neighbors_of(i, tree, x_coordinates, y_coordinates, neighbors_num, cost, scratch,
+                               &neighbors[static_cast<size_t>(i) * neighbors_num]);
+        }
+
+    });
+
+}
+
+#endif //VRP_NEIGHBORS_HPP
@@ -0,0 +1,87 @@
+#ifndef VRP_PARALLEL_HPP
+#define VRP_PARALLEL_HPP
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns the number of threads to use given a user defined value. Values smaller than one select all the
+ * available hardware threads.
+ * @param threads_num user defined number of threads
+ * @return number of threads
+ */
+inline int resolve_threads_num(int threads_num) {
+    if(threads_num < 1) {
+        threads_num = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    return std::max(1, threads_num);
+}
+
+/**
+ * Splits [begin, end) into at most threads_num contiguous chunks of similar size and processes them concurrently
+ * by calling function(chunk_begin, chunk_end). The calling thread takes care of the first chunk and returns once
+ * all of them are done. Concurrent calls of function must not write shared data, which makes the result independent
+ * of the number of threads. An exception thrown while processing a chunk or while starting a thread is rethrown once
+ * all the started threads are joined.
+ * @param begin first index
+ * @param end index after the last one
+ * @param threads_num number of threads
+ * @param function function processing a chunk
+ */
+template<class Function>
+void parallel_for(int begin, int end, int threads_num, const Function &function) {
+
+    const auto size = end - begin;
+    threads_num = std::max(1, std::min(threads_num, size));
+
+    if(threads_num == 1) {
+        function(begin, end);
+        return;
+    }
+
+    auto threads = std::vector<std::thread>();
+    threads.reserve(static_cast<size_t>(threads_num - 1));
+
+    const auto chunk_begin = [begin, size, threads_num](int chunk) {
+        return begin + static_cast<int>(static_cast<long>(size) * chunk / threads_num);
+    };
+
+    // exceptions must not reach a joinable thread, they are stored per chunk and rethrown after joining
+    auto errors = std::vector<std::exception_ptr>(static_cast<size_t>(threads_num));
+
+    const auto process_chunk = [&function, &chunk_begin, &errors](int chunk) {
+        try {
+            function(chunk_begin(chunk), chunk_begin(chunk + 1));
+        } catch (...) {
+            errors[static_cast<size_t>(chunk)] = std::current_exception();
+        }
+    };
+
+    try {
+        for(auto chunk = 1; chunk < threads_num; chunk++) {
+            threads.emplace_back(process_chunk, chunk);
+        }
+    } catch (...) {
+        for(auto &thread : threads) {
+            thread.join();
+        }
+        throw;
+    }
+
+    process_chunk(0);
+
+    for(auto &thread : threads) {
+        thread.join();
+    }
+
+    for(const auto &error : errors) {
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+}
+
+#endif //VRP_PARALLEL_HPP
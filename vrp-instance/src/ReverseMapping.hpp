@@ -0,0 +1,82 @@
+#ifndef VRP_REVERSEMAPPING_HPP
+#define VRP_REVERSEMAPPING_HPP
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Dense map from the vertices of an instance to the vertices of its sub-instances. Each sub-instance writes its
+ * entries under a different epoch and only reads the entries stamped with its own one, so that starting a new
+ * sub-instance never requires clearing the array. The same object can thus be reused by all the sub-instances of an
+ * instance and also shared by those alive at the same time as long as they contain disjoint sets of customers.
+ */
+class ReverseMapping {
+
+    struct Entry {
+        unsigned int epoch;
+        int vertex;
+    };
+
+    std::vector<Entry> entries;
+    unsigned int last_epoch = 0;
+
+public:
+
+    ReverseMapping() = default;
+
+    /**
+     * Builds a map able to store the vertices of an instance.
+     * @param vertices_num number of vertices of the instance
+     */
+    explicit ReverseMapping(int vertices_num) : entries(static_cast<size_t>(vertices_num), Entry{0, 0}) { }
+
+    /**
+     * Starts a new epoch, growing the array when needed. In the unlikely case the epochs counter wraps around, all
+     * the entries are cleared and the previous epochs become empty.
+     * @param vertices_num number of vertices of the instance
+     * @return epoch
+     */
+    unsigned int begin_epoch(int vertices_num) {
+        if (entries.size() < static_cast<size_t>(vertices_num)) {
+            entries.resize(static_cast<size_t>(vertices_num), Entry{0, 0});
+        }
+        if (++last_epoch == 0) {
+            std::fill(entries.begin(), entries.end(), Entry{0, 0});
+            last_epoch = 1;
+        }
+        return last_epoch;
+    }
+
+    /**
+     * Maps a vertex within the given epoch.
+     * @param epoch epoch
+     * @param vertex instance vertex
+     * @param mapped_vertex sub-instance vertex
+     */
+    inline void set(unsigned int epoch, int vertex, int mapped_vertex) {
+        entries[vertex] = Entry{epoch, mapped_vertex};
+    }
+
+    /**
+     * Returns whether a vertex is mapped within the given epoch.
+     * @param epoch epoch
+     * @param vertex instance vertex
+     * @return true if the vertex is mapped, false otherwise
+     */
+    inline bool contains(unsigned int epoch, int vertex) const {
+        return static_cast<size_t>(vertex) < entries.size() && entries[vertex].epoch == epoch;
+    }
+
+    /**
+     * Returns the vertex a given one is mapped to within the given epoch.
+     * @param epoch epoch
+     * @param vertex instance vertex
+     * @return sub-instance vertex, or 0 if vertex is not mapped
+     */
+    inline int get(unsigned int epoch, int vertex) const {
+        return contains(epoch, vertex) ? entries[vertex].vertex : 0;
+    }
+
+};
+
+#endif //VRP_REVERSEMAPPING_HPP
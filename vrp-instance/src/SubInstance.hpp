@@ -5,87 +5,333 @@
 #define VRP_SUBINSTANCE_HPP
 
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
-#include <unordered_map>
+#include <limits>
 #include "Instance.hpp"
+#include "ReverseMapping.hpp"
 
 /**
  * A class used to offer a partial consistent view over an AbstractInstance object.
  */
-class SubInstance : public AbstractInstance {
+class SubInstance final : public AbstractInstance {
+
+public:
+
+    /**
+     * Defines where the edge costs returned by get_cost are read from.
+     */
+    enum class CostsStorage {
+        /**
+         * Costs are read from the root instance through the mapping.
+         */
+        Root,
+        /**
+         * Costs are copied into a local vertices_num x vertices_num matrix. Cost lookups then touch a compact block
+         * which fits in cache for sub-instances of a few hundred vertices, at the price of a quadratic initialization.
+         */
+        Matrix,
+        /**
+         * A local matrix is used when the sub-instance has at most Options::max_matrix_vertices vertices.
+         */
+        Automatic
+    };
+
+    /**
+     * Settings used to build a SubInstance.
+     */
+    struct Options {
+        /**
+         * Number of nearest neighbors stored for each vertex, including the vertex itself. Values larger than the
+         * number of vertices keep all of them.
+         */
+        int neighbors_num = std::numeric_limits<int>::max();
+        /**
+         * Reverse mapping storage shared with other sub-instances of the same instance, whose ownership is not
+         * transferred. When null, the sub-instance allocates its own one, which is linear in the number of vertices
+         * of the instance.
+         */
+        ReverseMapping* reverse_mapping = nullptr;
+        /**
+         * Where the costs are read from.
+         */
+        CostsStorage costs_storage = CostsStorage::Root;
+        /**
+         * Largest number of vertices for which CostsStorage::Automatic selects a local matrix. The default one keeps
+         * the matrix within 1 MiB.
+         */
+        int max_matrix_vertices = 512;
+    };
+
+private:
 
     AbstractInstance& instance;
 
+    // nested sub-instances refer to the root instance directly, so that accesses cost the same at any depth. The
+    // root is an Instance, which is final, hence the calls through it are statically dispatched and inlined
+    const Instance& root;
+
     std::vector<int> mapping;
 
-    std::unordered_map<int, int> reverse_mapping;
+    std::vector<int> root_mapping;
+
+    // empty when costs are read from the root instance
+    std::vector<float> local_costs;
+
+    ReverseMapping own_reverse_mapping;
+
+    Options options;
+
+    unsigned int reverse_mapping_epoch;
 
     int customers_num;
 
     std::vector<float> features;
 
-    std::vector<std::vector<int>> neighbors;
+    int neighbors_num;
+
+    std::vector<Neighbor> neighbors;
+
+    KdTree spatial_index;
+
+    // buffers kept across retarget calls, so that they are only allocated when a larger sub-instance is defined
+    std::vector<float> x_coordinates;
+
+    std::vector<float> y_coordinates;
+
+    NeighborsScratch neighbors_scratch;
+
+    std::vector<std::pair<float, int>> neighbors_candidates;
+
+    inline ReverseMapping& get_reverse_mapping_storage() {
+        return options.reverse_mapping ? *options.reverse_mapping : own_reverse_mapping;
+    }
+
+    inline const ReverseMapping& get_reverse_mapping_storage() const {
+        return options.reverse_mapping ? *options.reverse_mapping : own_reverse_mapping;
+    }
+
+    void fill_local_costs() {
+
+        const auto vertices_num = static_cast<size_t>(get_vertices_num());
+
+        local_costs.resize(vertices_num * vertices_num);
+
+        // costs are symmetric, each one is read once from the root instance
+        for(auto i = 0ul; i < vertices_num; i++) {
+            local_costs[i * vertices_num + i] = root.get_cost(root_mapping[i], root_mapping[i]);
+            for(auto j = 0ul; j < i; j++) {
+                const auto cost = root.get_cost(root_mapping[i], root_mapping[j]);
+                local_costs[i * vertices_num + j] = cost;
+                local_costs[j * vertices_num + i] = cost;
+            }
+        }
+
+    }
+
+    static const Instance& get_root_of(const AbstractInstance& instance) {
+        const auto parent = dynamic_cast<const SubInstance*>(&instance);
+        return parent ? parent->root : dynamic_cast<const Instance&>(instance);
+    }
+
+    /**
+     * Builds the neighbors lists out of the parent ones. These are sorted by increasing cost, hence the list of a
+     * vertex is given by the parent neighbors belonging to the sub-instance, which are found in constant time through
+     * the reverse mapping. The scan goes on past the last neighbor while costs are tied, so that the list contains
+     * exactly the neighbors a full selection would pick. Vertices whose parent list is too short or too sparse to
+     * complete the list within a bounded scan are handled as in build_neighbors.
+     */
+    void build_neighbors_from_parent() {
+
+        const auto& reverse_mapping = get_reverse_mapping_storage();
+        const auto depot = instance.get_depot();
+        const auto vertices_num = get_vertices_num();
+        const auto list_size = static_cast<size_t>(neighbors_num);
+        const auto scan_limit = static_cast<size_t>(std::max(4 * neighbors_num, vertices_num));
+        const auto cost = [this](int i, int j) { return get_cost(i, j); };
+
+        auto& candidates = neighbors_candidates;
+
+        for(auto i = 0; i < vertices_num; i++) {
+
+            const auto vertex = mapping[i];
+            const auto parent_neighbors = instance.get_neighbor_entries_of(vertex);
+            const auto scan_end = std::min(parent_neighbors.size(), scan_limit);
+
+            // a whole parent list certainly contains all the sub-instance vertices
+            auto complete = scan_end == static_cast<size_t>(instance.get_vertices_num());
+
+            candidates.clear();
+            for(auto n = 0ul; n < scan_end; n++) {
+                const auto parent_neighbor = parent_neighbors[n].vertex;
+                if(parent_neighbor != depot && !reverse_mapping.contains(reverse_mapping_epoch, parent_neighbor)) {
+                    continue;
+                }
+                const auto neighbor = parent_neighbor == depot ? depot : reverse_mapping.get(reverse_mapping_epoch, parent_neighbor);
+                // sub-instance costs are the root ones, which the parent entries already hold
+                const auto neighbor_cost = parent_neighbors[n].cost;
+                if(candidates.size() >= list_size && neighbor_cost > candidates.back().first) {
+                    complete = true;
+                    break;
+                }
+                candidates.emplace_back(neighbor_cost, neighbor);
+            }
+
+            auto list = &neighbors[static_cast<size_t>(i) * neighbors_num];
+
+            if(complete && candidates.size() >= list_size) {
+                // the candidates are already sorted by cost with the vertex first, only the ties must be reordered
+                // according to the sub-instance indices
+                assert(candidates[0].second == i);
+                for(auto run_begin = candidates.begin() + 1; run_begin != candidates.end();) {
+                    auto run_end = run_begin + 1;
+                    while(run_end != candidates.end() && run_end->first == run_begin->first) {
+                        run_end++;
+                    }
+                    if(run_end - run_begin > 1) {
+                        std::sort(run_begin, run_end);
+                    }
+                    run_begin = run_end;
+                }
+                for(auto n = 0ul; n < list_size; n++) {
+                    list[n] = Neighbor{candidates[n].second, candidates[n].first};
+                }
+            } else {
+                build_neighbors_of(i, spatial_index, x_coordinates.data(), y_coordinates.data(), neighbors_num, cost,
+                                   neighbors_scratch, list);
+            }
+
+        }
+
+    }
 
 public:
 
-    SubInstance(AbstractInstance &instance_, std::vector<int>& customers) : instance(instance_) {
+    /**
+     * Builds a view over the given customers of instance.
+     * @param instance_ Instance or SubInstance, whose ownership is not transferred. std::bad_cast is thrown for other
+     * AbstractInstance implementations
+     * @param customers customers of instance defining the sub-instance, the depot must not be included
+     * @param neighbors_num_ number of nearest neighbors stored for each vertex, including the vertex itself. Values
+     * larger than the number of vertices keep all of them
+     */
+    SubInstance(AbstractInstance &instance_, std::vector<int>& customers, int neighbors_num_ = std::numeric_limits<int>::max()) :
+            SubInstance(instance_, customers, Options{neighbors_num_, nullptr}) { }
+
+    /**
+     * Builds a view over the given customers of instance.
+     * @param instance_ Instance or SubInstance, whose ownership is not transferred. std::bad_cast is thrown for other
+     * AbstractInstance implementations
+     * @param customers customers of instance defining the sub-instance, the depot must not be included
+     * @param options_ construction settings
+     */
+    SubInstance(AbstractInstance &instance_, std::vector<int>& customers, const Options& options_) :
+            instance(instance_), root(get_root_of(instance_)), options(options_) {
+
+        retarget(customers);
+
+    }
 
+    /**
+     * Turns the object into a view over a different set of customers of the same instance, with the options it has
+     * been built with. The buffers allocated for the previous customers are reused and only grow when the new
+     * sub-instance is larger, so that repeatedly defining sub-problems of bounded size does not allocate memory.
+     * The reverse mapping entries of the previous customers are discarded by starting a new epoch.
+     * @param customers customers of instance defining the sub-instance, the depot must not be included
+     */
+    void retarget(const std::vector<int>& customers) {
 
         customers_num = customers.size();
 
+        auto& reverse_mapping = get_reverse_mapping_storage();
+        reverse_mapping_epoch = reverse_mapping.begin_epoch(instance.get_vertices_num());
+
         // Define a 0-based mapping from this chunk of 'customers' to the real
         // customers. 'customers' must not contain the depot!
         mapping.resize(customers.size() + 1);
         mapping[instance.get_depot()] = instance.get_depot();
 
-        reverse_mapping[instance.get_depot()] = instance.get_depot();
-
-        neighbors.resize(mapping.size());
+        reverse_mapping.set(reverse_mapping_epoch, instance.get_depot(), instance.get_depot());
 
         for(auto i = 0ul; i < customers.size(); i++) {
 
             mapping[i+1] = customers[i];
-            reverse_mapping[customers[i]] = (i+1);
+            reverse_mapping.set(reverse_mapping_epoch, customers[i], static_cast<int>(i+1));
 
         }
 
-        auto all_vertices = std::vector<int>(customers_num+1);
+        const auto parent = dynamic_cast<const SubInstance*>(&instance);
 
-        for(auto i = get_vertices_begin(); i < get_vertices_end(); i++) {
-            all_vertices[i] = i;
+        root_mapping.resize(mapping.size());
+        for(auto i = 0ul; i < mapping.size(); i++) {
+            root_mapping[i] = parent ? parent->root_mapping[mapping[i]] : mapping[i];
+        }
+
+        if(options.costs_storage == CostsStorage::Matrix ||
+           (options.costs_storage == CostsStorage::Automatic && get_vertices_num() <= options.max_matrix_vertices)) {
+            fill_local_costs();
+        } else {
+            local_costs.clear();
         }
 
+        x_coordinates.resize(mapping.size());
+        y_coordinates.resize(mapping.size());
+
         for(auto i = get_vertices_begin(); i < get_vertices_end(); i++) {
+            x_coordinates[i] = get_x_coordinate(i);
+            y_coordinates[i] = get_y_coordinate(i);
+        }
 
-            std::sort(all_vertices.begin(), all_vertices.end(), [this, i](auto j, auto k){ return this->get_cost(i,j) < this->get_cost(i, k);});
+        spatial_index.assign(x_coordinates.data(), y_coordinates.data(), get_vertices_num());
 
-            neighbors[i] = all_vertices;
+        neighbors_num = std::max(1, std::min(options.neighbors_num, get_vertices_num()));
+        neighbors.resize(static_cast<size_t>(get_vertices_num()) * neighbors_num);
 
-            // ensure that the first vertex is i
-            if(neighbors[i][0] != i) {
-                auto n = 1;
-                while(n < get_vertices_num()) {
-                    if(neighbors[i][n] == i) {
-                        break;
-                    }
-                    n++;
-                }
-                std::swap(neighbors[i][0], neighbors[i][n]);
-            }
+        build_neighbors_from_parent();
 
-            assert(neighbors[i][0] == i);
+    }
 
-        }
+    inline int get_mapping(int i) const {
+        return mapping[i];
+    }
 
+    /**
+     * Returns the Instance at the root of the chain of sub-instances this one has been built on.
+     * @return root instance
+     */
+    inline const Instance& get_root() const {
+        return root;
+    }
 
-}
+    /**
+     * Returns the vertex of the root instance corresponding to a sub-instance vertex. It differs from get_mapping
+     * only when the sub-instance has been built on top of another sub-instance.
+     * @param i sub-instance vertex
+     * @return root instance vertex
+     */
+    inline int get_root_mapping(int i) const {
+        return root_mapping[i];
+    }
 
-    inline int get_mapping(int i) {
-        return mapping[i];
+    /**
+     * Returns whether the costs are stored in a local matrix.
+     * @return true if costs are stored locally, false if they are read from the root instance
+     */
+    inline bool has_local_costs() const {
+        return !local_costs.empty();
     }
 
-    inline int get_reverse_mapping(int vertex_original_coordinates) {
-        return reverse_mapping[vertex_original_coordinates];
+    /**
+     * Returns the sub-instance vertex corresponding to a vertex of the original instance in constant time.
+     * @param vertex_original_coordinates vertex of the original instance
+     * @return sub-instance vertex, or 0 if the vertex does not belong to the sub-instance
+     */
+    inline int get_reverse_mapping(int vertex_original_coordinates) const {
+        if(vertex_original_coordinates == root.get_depot()) {
+            return get_depot();
+        }
+        return get_reverse_mapping_storage().get(reverse_mapping_epoch, vertex_original_coordinates);
     }
 
     inline int get_customers_num() const override {
@@ -112,23 +358,64 @@ public:
         return mapping.size();
     }
 
+    /**
+     * Returns the cost of arc (i, j). A lookup is either a read of the local matrix or a single hop to the root
+     * instance through root_mapping, whatever the nesting depth; the root call is statically dispatched. The test on
+     * local_costs that selects between the two is paid on every lookup: it is a well-predicted compare on a member
+     * that never changes after construction, so it can be hoisted out of loops, but it is not free.
+     * @param i first vertex
+     * @param j second vertex
+     * @return arc cost
+     */
     inline float get_cost(int i, int j) const override {
-        return instance.get_cost(mapping[i], mapping[j]);
+        if(!local_costs.empty()) {
+            return local_costs[static_cast<size_t>(i) * mapping.size() + j];
+        }
+        return root.get_cost(root_mapping[i], root_mapping[j]);
+    }
+
+    inline bool has_integer_costs() const override { return root.has_integer_costs(); }
+
+    /**
+     * Returns the integer cost of arc (i, j), with the same lookup path and per-lookup local_costs test as get_cost.
+     * @param i first vertex
+     * @param j second vertex
+     * @return arc cost
+     */
+    inline int get_integer_cost(int i, int j) const override {
+        if(!local_costs.empty()) {
+            return static_cast<int>(local_costs[static_cast<size_t>(i) * mapping.size() + j]);
+        }
+        return root.get_integer_cost(root_mapping[i], root_mapping[j]);
     }
 
-    inline bool is_valid() const override { return instance.is_valid(); }
+    inline bool is_valid() const override { return root.is_valid(); }
 
-    inline int get_depot() const override { return instance.get_depot(); }
+    inline int get_depot() const override { return root.get_depot(); }
 
-    inline int get_vehicle_capacity() const override { return instance.get_vehicle_capacity(); }
+    inline int get_vehicle_capacity() const override { return root.get_vehicle_capacity(); }
 
-    inline int get_demand(int i) const override { return instance.get_demand(mapping[i]); }
+    inline int get_demand(int i) const override { return root.get_demand(root_mapping[i]); }
 
-    inline std::vector<int> &get_neighbors_of(int i) override { return neighbors[i]; }
+    inline NeighborsView get_neighbors_of(int i) const override {
+        return NeighborsView(&neighbors[static_cast<size_t>(i) * neighbors_num], static_cast<size_t>(neighbors_num));
+    }
+
+    inline NeighborsSpan get_neighbor_entries_of(int i) const override {
+        return NeighborsSpan(&neighbors[static_cast<size_t>(i) * neighbors_num], static_cast<size_t>(neighbors_num));
+    }
 
-    inline float get_x_coordinate(int customer) const override { return instance.get_x_coordinate(mapping[customer]); }
+    inline float get_x_coordinate(int customer) const override { return root.get_x_coordinate(root_mapping[customer]); }
 
-    inline float get_y_coordinate(int customer) const override { return instance.get_y_coordinate(mapping[customer]); }
+    inline float get_y_coordinate(int customer) const override { return root.get_y_coordinate(root_mapping[customer]); }
+
+    inline void get_nearest_vertices(float x, float y, int k, std::vector<int>& vertices) const override {
+        spatial_index.get_nearest(x, y, k, vertices);
+    }
+
+    inline void get_vertices_within_radius(float x, float y, float radius, std::vector<int>& vertices) const override {
+        spatial_index.get_within_radius(x, y, radius, vertices);
+    }
 
 };
 
@@ -6,6 +6,11 @@
 #include <gmock/gmock.h>
 #include <Instance.hpp>
 #include <SubInstance.hpp>
+#include <CostsKernel.hpp>
+#include <BinaryInstance.hpp>
+#include <Parallel.hpp>
+#include <fstream>
+#include <unistd.h>
 
 int main(int argc, char* argv[]) {
     testing::InitGoogleTest(&argc, argv);
@@ -56,6 +61,14 @@ namespace {
 
     }
 
+    TEST_F(InstanceTests, DirectoryPath) {
+
+        auto instance = Instance("../../../instances");
+
+        ASSERT_EQ(instance.is_valid(), false);
+
+    }
+
     TEST_F(InstanceTests, Initialization)
 
     {
@@ -94,6 +107,572 @@ namespace {
 
     }
 
+    TEST_F(InstanceTests, TextParsers) {
+
+        // tokens exercising both the fast and the strtof based conversions, which must match stof and stoi
+        auto x_tokens = std::vector<std::string>({"0", "-12.5", "29.6307", "0.1", "+3.", "1e2", "123456789.123456789"});
+        auto y_tokens = std::vector<std::string>({"0", ".5", "-0.0000", "16777217", "0.30000001192092896", "2.5E-3", "7"});
+
+        std::string path = "text-parsers.txt";
+        auto stream = std::ofstream(path);
+        stream << x_tokens.size() - 1 << "\t" << "100.9 1000\r\n";
+        for(auto i = 0u; i < x_tokens.size(); i++) {
+            stream << i << "  " << x_tokens[i] << "\t" << y_tokens[i] << " " << (i == 0 ? "0" : "10.0000") << "\r\n";
+        }
+        stream.close();
+
+        auto instance = Instance(path);
+        std::remove(path.c_str());
+
+        ASSERT_EQ(instance.is_valid(), true);
+        ASSERT_EQ(instance.get_vehicle_capacity(), 100);
+        ASSERT_EQ(instance.get_vertices_num(), static_cast<int>(x_tokens.size()));
+
+        for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+            ASSERT_EQ(instance.get_x_coordinate(i), std::stof(x_tokens[i]));
+            ASSERT_EQ(instance.get_y_coordinate(i), std::stof(y_tokens[i]));
+            ASSERT_EQ(instance.get_demand(i), i == 0 ? 0 : 10);
+        }
+
+    }
+
+    TEST_F(InstanceTests, OnTheFlyCosts) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+
+        auto options = Instance::Options();
+        options.costs_storage = Instance::CostsStorage::OnTheFly;
+
+        auto instance = Instance(right_path, options);
+        auto matrix_instance = Instance(right_path);
+
+        ASSERT_EQ(instance.is_valid(), true);
+
+        test_instance(instance, 600, 105, 106);
+
+        for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+            for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                ASSERT_EQ(instance.get_cost(i, j), matrix_instance.get_cost(i, j));
+            }
+        }
+
+    }
+
+    TEST_F(InstanceTests, NearestNeighbors) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 25;
+
+        auto instance = Instance(right_path, options);
+        auto full_instance = Instance(right_path);
+
+        ASSERT_EQ(instance.is_valid(), true);
+
+        for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+            const auto neighbors = instance.get_neighbors_of(i);
+            ASSERT_EQ(neighbors.size(), 25u);
+            ASSERT_EQ(neighbors[0], i);
+            for(auto n = 0u; n < neighbors.size(); n++) {
+                ASSERT_EQ(neighbors[n], full_instance.get_neighbors_of(i)[n]);
+            }
+        }
+
+        auto subset = std::vector<int>({59, 32, 45, 11, 7, 1});
+
+        auto sub_instance = SubInstance(instance, subset, 3);
+
+        for(auto i = sub_instance.get_vertices_begin(); i < sub_instance.get_vertices_end(); i++) {
+            const auto neighbors = sub_instance.get_neighbors_of(i);
+            ASSERT_EQ(neighbors.size(), 3u);
+            ASSERT_EQ(neighbors[0], i);
+            for(auto j = sub_instance.get_vertices_begin(); j < sub_instance.get_vertices_end(); j++) {
+                if(std::find(neighbors.begin(), neighbors.end(), j) == neighbors.end()) {
+                    ASSERT_GE(sub_instance.get_cost(i, j), sub_instance.get_cost(i, neighbors[2]));
+                }
+            }
+        }
+
+    }
+
+    TEST_F(InstanceTests, NeighborsTies) {
+
+        // an irregular grid, whose rounded costs tie at different distances
+        auto x = std::vector<float>();
+        auto y = std::vector<float>();
+        for(auto i = 0; i < 30; i++) {
+            for(auto j = 0; j < 30; j++) {
+                x.push_back(0.7f * static_cast<float>(i));
+                y.push_back(0.9f * static_cast<float>(j));
+            }
+        }
+        const auto n = static_cast<int>(x.size());
+        const auto cost = [&x, &y](int i, int j) { return euclidean_cost(x[i], y[i], x[j], y[j], true); };
+
+        const auto tree = KdTree(x.data(), y.data(), n);
+        auto scratch = NeighborsScratch();
+        auto costs = std::vector<float>(static_cast<size_t>(n));
+        auto candidates = std::vector<int>();
+
+        for(auto k : {1, 2, 7, 13, 40}) {
+
+            ASSERT_LT(k * 8, n);
+
+            auto neighbors = std::vector<Neighbor>(static_cast<size_t>(k));
+            auto expected = std::vector<Neighbor>(static_cast<size_t>(k));
+
+            for(auto i = 0; i < n; i++) {
+                for(auto j = 0; j < n; j++) {
+                    costs[j] = cost(i, j);
+                }
+                select_neighbors(i, costs.data(), n, k, candidates, expected.data());
+                build_neighbors_of(i, tree, x.data(), y.data(), k, cost, scratch, neighbors.data());
+                for(auto m = 0; m < k; m++) {
+                    ASSERT_EQ(neighbors[m].vertex, expected[m].vertex);
+                    ASSERT_EQ(neighbors[m].cost, expected[m].cost);
+                }
+            }
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, SpatialQueries) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 10;
+
+        auto instance = Instance(right_path, options);
+
+        ASSERT_EQ(instance.is_valid(), true);
+
+        auto vertices = std::vector<int>();
+        auto brute_force = std::vector<std::pair<float, int>>();
+
+        for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i += 97) {
+
+            const auto x = instance.get_x_coordinate(i) + 0.5f;
+            const auto y = instance.get_y_coordinate(i) - 0.25f;
+
+            brute_force.clear();
+            for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                const auto dx = x - instance.get_x_coordinate(j);
+                const auto dy = y - instance.get_y_coordinate(j);
+                brute_force.emplace_back(dx * dx + dy * dy, j);
+            }
+            std::sort(brute_force.begin(), brute_force.end());
+
+            instance.get_nearest_vertices(x, y, 15, vertices);
+            ASSERT_EQ(vertices.size(), 15u);
+            for(auto n = 0u; n < vertices.size(); n++) {
+                ASSERT_EQ(vertices[n], brute_force[n].second);
+            }
+
+            const auto radius = 50.0f;
+            instance.get_vertices_within_radius(x, y, radius, vertices);
+            const auto inside = std::count_if(brute_force.begin(), brute_force.end(), [radius](const std::pair<float, int> &item) { return item.first <= radius * radius; });
+            ASSERT_EQ(static_cast<long>(vertices.size()), inside);
+
+            // lists built through the spatial index are as good as the full sorting
+            const auto neighbors = instance.get_neighbors_of(i);
+            ASSERT_EQ(neighbors.size(), 10u);
+            ASSERT_EQ(neighbors[0], i);
+            auto costs = std::vector<float>();
+            for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                if(j != i) { costs.push_back(instance.get_cost(i, j)); }
+            }
+            std::sort(costs.begin(), costs.end());
+            for(auto n = 1u; n < neighbors.size(); n++) {
+                ASSERT_EQ(instance.get_cost(i, neighbors[n]), costs[n - 1]);
+            }
+
+        }
+
+        auto subset = std::vector<int>({59, 32, 45, 11, 7, 1});
+        auto sub_instance = SubInstance(instance, subset);
+
+        sub_instance.get_nearest_vertices(sub_instance.get_x_coordinate(3), sub_instance.get_y_coordinate(3), 1, vertices);
+        ASSERT_EQ(vertices, std::vector<int>({3}));
+
+    }
+
+    TEST_F(InstanceTests, ParallelConstruction) {
+
+        for(auto neighbors_num : {10, 1000}) {
+
+            std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+            auto options = Instance::Options();
+            options.neighbors_num = neighbors_num;
+
+            auto serial_instance = Instance(right_path, options);
+
+            options.threads_num = 3;
+
+            auto instance = Instance(right_path, options);
+
+            ASSERT_EQ(instance.is_valid(), true);
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                    ASSERT_EQ(instance.get_cost(i, j), serial_instance.get_cost(i, j));
+                }
+                const auto neighbors = instance.get_neighbors_of(i);
+                const auto serial_neighbors = serial_instance.get_neighbors_of(i);
+                ASSERT_TRUE(std::equal(neighbors.begin(), neighbors.end(), serial_neighbors.begin(), serial_neighbors.end()));
+            }
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, ParallelForExceptions) {
+
+        for(auto failing_index : {0, 50, 99}) {
+
+            auto processed = std::vector<int>(100, 0);
+
+            ASSERT_THROW(parallel_for(0, 100, 4, [&processed, failing_index](int begin, int end) {
+                for(auto i = begin; i < end; i++) {
+                    if(i == failing_index) {
+                        throw std::runtime_error("failing index");
+                    }
+                    processed[i] = 1;
+                }
+            }), std::runtime_error);
+
+            // the other chunks are processed before the exception is rethrown
+            ASSERT_EQ(processed[25], 1);
+            ASSERT_EQ(processed[75], 1);
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, CostsKernels) {
+
+        std::string right_path = "../../../instances/ZK/21.txt";
+
+        auto options = Instance::Options();
+        options.costs_storage = Instance::CostsStorage::OnTheFly;
+
+        auto instance = Instance(right_path, options);
+
+        ASSERT_EQ(instance.is_valid(), true);
+
+        const auto n = instance.get_vertices_num();
+
+        auto x = std::vector<float>();
+        auto y = std::vector<float>();
+        for(auto i = 0; i < n; i++) {
+            x.push_back(instance.get_x_coordinate(i));
+            y.push_back(instance.get_y_coordinate(i));
+        }
+
+        auto reference = std::vector<float>(n);
+        auto costs = std::vector<float>(n);
+
+        for(auto round_costs : {true, false}) {
+            for(const auto &kernel : get_supported_costs_row_kernels()) {
+                for(auto i = 0; i < n; i++) {
+                    // odd ranges to exercise the tails
+                    const auto begin = i % 7;
+                    const auto end = n - i % 5;
+                    compute_costs_row_scalar(x.data(), y.data(), i, begin, end, round_costs, reference.data());
+                    kernel.second(x.data(), y.data(), i, begin, end, round_costs, costs.data());
+                    for(auto j = begin; j < end; j++) {
+                        ASSERT_EQ(costs[j - begin], reference[j - begin]) << kernel.first;
+                        ASSERT_EQ(costs[j - begin], euclidean_cost(x[i], y[i], x[j], y[j], round_costs));
+                    }
+                }
+            }
+        }
+
+        // exact halfway cases are rounded away from zero as std::round does
+        x = {0.0f, 2.5f, 0.5f, 0.0f, 3.0f, 1.5f, 4.5f, 0.0f, 0.0f, 6.5f, 0.0f};
+        y = std::vector<float>(x.size(), 0.0f);
+        for(const auto &kernel : get_supported_costs_row_kernels()) {
+            kernel.second(x.data(), y.data(), 0, 0, static_cast<int>(x.size()), true, costs.data());
+            for(auto j = 0u; j < x.size(); j++) {
+                ASSERT_EQ(costs[j], std::round(x[j])) << kernel.first;
+            }
+        }
+
+    }
+
+    TEST_F(InstanceTests, IntegerCosts) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 10;
+
+        auto float_instance = Instance(right_path, options);
+
+        options.integer_costs = true;
+
+        auto instance = Instance(right_path, options);
+
+        ASSERT_EQ(instance.is_valid(), true);
+        ASSERT_EQ(instance.has_integer_costs(), true);
+
+        // coordinates are small enough for 16 bits costs
+        ASSERT_EQ(instance.get_costs_memory_usage() * 2, float_instance.get_costs_memory_usage());
+
+        for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+            for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                ASSERT_EQ(instance.get_cost(i, j), float_instance.get_cost(i, j));
+                ASSERT_EQ(instance.get_integer_cost(i, j), static_cast<int>(float_instance.get_cost(i, j)));
+            }
+        }
+
+        auto subset = std::vector<int>({59, 32, 45, 11, 7, 1});
+        auto sub_instance = SubInstance(instance, subset);
+
+        ASSERT_EQ(sub_instance.has_integer_costs(), true);
+        ASSERT_EQ(sub_instance.get_integer_cost(1, 2), instance.get_integer_cost(59, 32));
+
+        // costs cannot be integers when not rounded
+        options.round_costs = false;
+        auto real_instance = Instance("../../../instances/ZK/21.txt", options);
+        ASSERT_EQ(real_instance.has_integer_costs(), false);
+        ASSERT_EQ(real_instance.get_costs_memory_usage(), 561u * 561u * sizeof(float));
+
+    }
+
+    TEST_F(InstanceTests, TypedCosts) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+        auto reference_options = Instance::Options();
+        reference_options.neighbors_num = 10;
+        const auto reference = Instance(right_path, reference_options);
+
+        for(auto costs_storage : {Instance::CostsStorage::Matrix, Instance::CostsStorage::TriangularMatrix, Instance::CostsStorage::OnTheFly}) {
+            for(auto integer_costs : {false, true}) {
+
+                auto options = reference_options;
+                options.costs_storage = costs_storage;
+                options.integer_costs = integer_costs;
+                const auto instance = Instance(right_path, options);
+
+                // the lookups are picked once, their type is the one of the stored elements
+                const auto uses_16_bits = instance.visit_costs([](const auto& costs) {
+                    using Costs = typename std::decay<decltype(costs)>::type;
+                    return std::is_same<Costs, Instance::MatrixCosts<uint16_t>>::value ||
+                           std::is_same<Costs, Instance::TriangularMatrixCosts<uint16_t>>::value;
+                });
+                ASSERT_EQ(uses_16_bits, integer_costs && costs_storage != Instance::CostsStorage::OnTheFly);
+
+                const auto totals = instance.visit_costs([&instance](const auto& costs) {
+                    auto total = std::make_pair(0.0, 0l);
+                    for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                        for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                            total.first += costs.get_cost(i, j);
+                            total.second += costs.get_integer_cost(i, j);
+                        }
+                    }
+                    return total;
+                });
+
+                auto expected = std::make_pair(0.0, 0l);
+                for(auto i = reference.get_vertices_begin(); i < reference.get_vertices_end(); i++) {
+                    for(auto j = reference.get_vertices_begin(); j < reference.get_vertices_end(); j++) {
+                        ASSERT_EQ(instance.get_integer_cost(i, j), reference.get_integer_cost(i, j));
+                        expected.first += reference.get_cost(i, j);
+                        expected.second += reference.get_integer_cost(i, j);
+                    }
+                }
+                ASSERT_EQ(totals, expected);
+
+            }
+        }
+
+    }
+
+    TEST_F(InstanceTests, PaddedCostsRows) {
+
+        std::string right_path = "../../../instances/ZK/21.txt";
+
+        for(auto integer_costs : {false, true}) {
+
+            auto options = Instance::Options();
+            options.neighbors_num = 20;
+            options.integer_costs = integer_costs;
+
+            auto instance = Instance(right_path, options);
+
+            // the placement of the pages does not change the costs
+            options.huge_pages = true;
+            options.padded_rows = true;
+            options.numa_interleave = true;
+
+            auto padded_instance = Instance(right_path, options);
+
+            ASSERT_EQ(padded_instance.is_valid(), true);
+            ASSERT_EQ(padded_instance.get_costs_memory_usage() / 561u % 64u, 0u);
+            ASSERT_GT(padded_instance.get_costs_memory_usage(), instance.get_costs_memory_usage());
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                    ASSERT_EQ(padded_instance.get_cost(i, j), instance.get_cost(i, j));
+                }
+                const auto neighbors = instance.get_neighbors_of(i);
+                const auto padded_neighbors = padded_instance.get_neighbors_of(i);
+                ASSERT_EQ(std::vector<int>(padded_neighbors.begin(), padded_neighbors.end()),
+                          std::vector<int>(neighbors.begin(), neighbors.end()));
+            }
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, TriangularCosts) {
+
+        for(auto integer_costs : {false, true}) {
+
+            std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+            auto options = Instance::Options();
+            options.neighbors_num = 10;
+            options.integer_costs = integer_costs;
+
+            auto full_instance = Instance(right_path, options);
+
+            options.costs_storage = Instance::CostsStorage::TriangularMatrix;
+            options.threads_num = 3;
+
+            auto instance = Instance(right_path, options);
+
+            ASSERT_EQ(instance.is_valid(), true);
+
+            const auto n = static_cast<size_t>(instance.get_vertices_num());
+            ASSERT_EQ(instance.get_costs_memory_usage() * 2 * n, full_instance.get_costs_memory_usage() * (n + 1));
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                    ASSERT_EQ(instance.get_cost(i, j), full_instance.get_cost(i, j));
+                }
+            }
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, BinaryInstance) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+        std::string binary_path = "X-n106-k14.bin";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 25;
+        options.integer_costs = true;
+
+        auto instance = Instance(right_path, options);
+
+        ASSERT_EQ(instance.is_valid(), true);
+
+        for(auto format : {AbstractInstance::SerializationFormat::Binary, AbstractInstance::SerializationFormat::BinaryWithCosts}) {
+
+            ASSERT_TRUE(instance.serialize(binary_path, format));
+            ASSERT_FALSE(instance.serialize("missing-directory/" + binary_path, format));
+
+            auto mapped_instance = Instance(binary_path);
+
+            ASSERT_EQ(mapped_instance.is_valid(), true);
+            ASSERT_EQ(mapped_instance.is_memory_mapped(), true);
+            ASSERT_EQ(mapped_instance.get_vehicle_capacity(), instance.get_vehicle_capacity());
+            ASSERT_EQ(mapped_instance.get_vertices_num(), instance.get_vertices_num());
+            ASSERT_EQ(mapped_instance.has_integer_costs(), instance.has_integer_costs());
+            ASSERT_EQ(mapped_instance.get_costs_storage() == Instance::CostsStorage::OnTheFly,
+                      format == AbstractInstance::SerializationFormat::Binary);
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                ASSERT_EQ(mapped_instance.get_x_coordinate(i), instance.get_x_coordinate(i));
+                ASSERT_EQ(mapped_instance.get_y_coordinate(i), instance.get_y_coordinate(i));
+                ASSERT_EQ(mapped_instance.get_demand(i), instance.get_demand(i));
+                const auto neighbors = instance.get_neighbors_of(i);
+                const auto mapped_neighbors = mapped_instance.get_neighbors_of(i);
+                ASSERT_EQ(std::vector<int>(mapped_neighbors.begin(), mapped_neighbors.end()),
+                          std::vector<int>(neighbors.begin(), neighbors.end()));
+                for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                    ASSERT_EQ(mapped_instance.get_cost(i, j), instance.get_cost(i, j));
+                    ASSERT_EQ(mapped_instance.get_integer_cost(i, j), instance.get_integer_cost(i, j));
+                }
+            }
+
+            auto vertices = std::vector<int>();
+            auto mapped_vertices = std::vector<int>();
+            instance.get_nearest_vertices(50.0f, 50.0f, 10, vertices);
+            mapped_instance.get_nearest_vertices(50.0f, 50.0f, 10, mapped_vertices);
+            ASSERT_EQ(mapped_vertices, vertices);
+
+        }
+
+        // a neighbor outside the vertices range makes the file invalid
+        ASSERT_TRUE(instance.serialize(binary_path, AbstractInstance::SerializationFormat::Binary));
+        {
+            auto header = BinaryInstanceHeader();
+            auto file = std::fstream(binary_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.read(reinterpret_cast<char *>(&header), sizeof(header));
+            const auto corrupted = Neighbor{instance.get_vertices_num(), 0.0f};
+            file.seekp(static_cast<std::streamoff>(header.neighbors_offset + 3 * sizeof(Neighbor)));
+            file.write(reinterpret_cast<const char *>(&corrupted), sizeof(corrupted));
+        }
+        ASSERT_FALSE(Instance(binary_path).is_valid());
+
+        std::remove(binary_path.c_str());
+
+    }
+
+    TEST_F(InstanceTests, InstanceMove) {
+
+        static_assert(!std::is_copy_constructible<Instance>::value, "copies would share the owned memory");
+        static_assert(!std::is_copy_assignable<Instance>::value, "copies would share the owned memory");
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+        std::string binary_path = "X-n106-k14-move.bin";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 25;
+
+        const auto reference = Instance(right_path, options);
+        ASSERT_TRUE(reference.serialize(binary_path, AbstractInstance::SerializationFormat::BinaryWithCosts));
+
+        options.integer_costs = true;
+
+        for(auto mapped : {false, true}) {
+
+            auto source = mapped ? Instance(binary_path) : Instance(right_path, options);
+            ASSERT_EQ(source.is_memory_mapped(), mapped);
+
+            auto instance = std::move(source);
+
+            // the moved-to instance owns the data, which assignment releases exactly once
+            auto assigned = Instance(right_path);
+            assigned = std::move(instance);
+
+            ASSERT_EQ(assigned.is_valid(), true);
+            ASSERT_EQ(assigned.is_memory_mapped(), mapped);
+            for(auto i = reference.get_vertices_begin(); i < reference.get_vertices_end(); i++) {
+                ASSERT_EQ(assigned.get_demand(i), reference.get_demand(i));
+                for(auto j = reference.get_vertices_begin(); j < reference.get_vertices_end(); j++) {
+                    ASSERT_EQ(assigned.get_cost(i, j), reference.get_cost(i, j));
+                }
+                const auto neighbors = assigned.get_neighbors_of(i);
+                const auto reference_neighbors = reference.get_neighbors_of(i);
+                ASSERT_TRUE(std::equal(neighbors.begin(), neighbors.end(), reference_neighbors.begin(), reference_neighbors.end()));
+            }
+
+        }
+
+        std::remove(binary_path.c_str());
+
+    }
+
     TEST_F(InstanceTests, SubInstance) {
 
         std::string right_path = "../../../instances/X/X-n106-k14.vrp";
@@ -113,5 +692,360 @@ namespace {
 
     }
 
+    TEST_F(InstanceTests, SubInstanceNeighbors) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+        for(auto parent_neighbors_num : {std::numeric_limits<int>::max(), 50}) {
+
+            auto options = Instance::Options();
+            options.neighbors_num = parent_neighbors_num;
+            auto instance = Instance(right_path, options);
+
+            // a compact subset, whose lists are mostly derived from the parent ones, and a sparse one
+            auto compact_subset = std::vector<int>();
+            instance.get_nearest_vertices(instance.get_x_coordinate(1), instance.get_y_coordinate(1), 301, compact_subset);
+            compact_subset.erase(std::remove(compact_subset.begin(), compact_subset.end(), instance.get_depot()), compact_subset.end());
+            compact_subset.resize(300);
+            auto sparse_subset = std::vector<int>();
+            for(auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i += 11) {
+                sparse_subset.push_back(i);
+            }
+
+            for(auto subset : {compact_subset, sparse_subset}) {
+                for(auto neighbors_num : {10, 60, std::numeric_limits<int>::max()}) {
+
+                    auto sub_instance = SubInstance(instance, subset, neighbors_num);
+                    const auto n = sub_instance.get_vertices_num();
+                    const auto k = std::min(neighbors_num, n);
+
+                    auto costs = std::vector<float>(static_cast<size_t>(n));
+                    auto candidates = std::vector<int>();
+                    auto expected = std::vector<Neighbor>(static_cast<size_t>(k));
+
+                    for(auto i = sub_instance.get_vertices_begin(); i < sub_instance.get_vertices_end(); i++) {
+                        for(auto j = sub_instance.get_vertices_begin(); j < sub_instance.get_vertices_end(); j++) {
+                            costs[j] = sub_instance.get_cost(i, j);
+                        }
+                        select_neighbors(i, costs.data(), n, k, candidates, expected.data());
+                        const auto neighbors = sub_instance.get_neighbors_of(i);
+                        ASSERT_EQ(neighbors.size(), static_cast<size_t>(k));
+                        ASSERT_EQ(neighbors[0], i);
+                        for(auto m = 0; m < k; m++) {
+                            ASSERT_EQ(costs[neighbors[m]], costs[expected[m].vertex]);
+                        }
+                    }
+
+                }
+            }
+
+        }
+
+    }
+
+    TEST_F(InstanceTests, NestedSubInstance) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+
+        auto instance = Instance(right_path);
+
+        auto subset = std::vector<int>();
+        for(auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i += 2) {
+            subset.push_back(i);
+        }
+        auto sub_instance = SubInstance(instance, subset);
+
+        auto sub_subset = std::vector<int>({40, 3, 17, 25, 8, 51});
+        auto sub_sub_instance = SubInstance(sub_instance, sub_subset);
+
+        auto sub_sub_subset = std::vector<int>({5, 2, 4});
+        auto sub_sub_sub_instance = SubInstance(sub_sub_instance, sub_sub_subset);
+
+        ASSERT_EQ(sub_sub_sub_instance.is_valid(), true);
+        ASSERT_EQ(sub_sub_sub_instance.get_vertices_num(), 4);
+
+        for(auto i = sub_sub_sub_instance.get_vertices_begin(); i < sub_sub_sub_instance.get_vertices_end(); i++) {
+
+            const auto parent_vertex = sub_sub_sub_instance.get_mapping(i);
+            const auto root_vertex = sub_instance.get_mapping(sub_sub_instance.get_mapping(parent_vertex));
+
+            ASSERT_EQ(parent_vertex, i == 0 ? 0 : sub_sub_subset[i - 1]);
+            ASSERT_EQ(sub_sub_sub_instance.get_root_mapping(i), root_vertex);
+            ASSERT_EQ(sub_sub_sub_instance.get_demand(i), instance.get_demand(root_vertex));
+            ASSERT_EQ(sub_sub_sub_instance.get_x_coordinate(i), instance.get_x_coordinate(root_vertex));
+
+            for(auto j = sub_sub_sub_instance.get_vertices_begin(); j < sub_sub_sub_instance.get_vertices_end(); j++) {
+                ASSERT_EQ(sub_sub_sub_instance.get_cost(i, j), sub_sub_instance.get_cost(parent_vertex, sub_sub_sub_instance.get_mapping(j)));
+            }
+
+        }
+
+        test_instance(sub_sub_sub_instance, 600, 3, 4);
+
+    }
+
+    TEST_F(InstanceTests, SubInstanceLocalCosts) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+
+        auto instance = Instance(right_path);
+
+        auto subset = std::vector<int>();
+        for(auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i += 7) {
+            subset.push_back(i);
+        }
+
+        auto options = SubInstance::Options();
+        options.neighbors_num = 25;
+
+        auto sub_instance = SubInstance(instance, subset, options);
+
+        options.costs_storage = SubInstance::CostsStorage::Matrix;
+        auto local_sub_instance = SubInstance(instance, subset, options);
+
+        options.costs_storage = SubInstance::CostsStorage::Automatic;
+        auto automatic_sub_instance = SubInstance(instance, subset, options);
+        options.max_matrix_vertices = static_cast<int>(subset.size());
+        auto small_automatic_sub_instance = SubInstance(instance, subset, options);
+
+        ASSERT_EQ(sub_instance.has_local_costs(), false);
+        ASSERT_EQ(local_sub_instance.has_local_costs(), true);
+        ASSERT_EQ(automatic_sub_instance.has_local_costs(), true);
+        ASSERT_EQ(small_automatic_sub_instance.has_local_costs(), false);
+
+        for(auto i = sub_instance.get_vertices_begin(); i < sub_instance.get_vertices_end(); i++) {
+            for(auto j = sub_instance.get_vertices_begin(); j < sub_instance.get_vertices_end(); j++) {
+                ASSERT_EQ(local_sub_instance.get_cost(i, j), sub_instance.get_cost(i, j));
+                ASSERT_EQ(local_sub_instance.get_integer_cost(i, j), sub_instance.get_integer_cost(i, j));
+            }
+            const auto neighbors = sub_instance.get_neighbors_of(i);
+            const auto local_neighbors = local_sub_instance.get_neighbors_of(i);
+            ASSERT_EQ(std::vector<int>(local_neighbors.begin(), local_neighbors.end()),
+                      std::vector<int>(neighbors.begin(), neighbors.end()));
+        }
+
+    }
+
+    TEST_F(InstanceTests, SubInstanceReverseMapping) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+
+        auto instance = Instance(right_path);
+
+        auto first_subset = std::vector<int>({59, 32, 45, 11, 7, 1});
+        auto second_subset = std::vector<int>({2, 3, 105, 60});
+
+        // sub-instances with disjoint customers can share the storage while alive
+        auto reverse_mapping = ReverseMapping();
+        auto options = SubInstance::Options();
+        options.reverse_mapping = &reverse_mapping;
+
+        auto first_sub_instance = SubInstance(instance, first_subset, options);
+        auto second_sub_instance = SubInstance(instance, second_subset, options);
+        auto own_sub_instance = SubInstance(instance, first_subset);
+
+        for(auto sub_instance : {&first_sub_instance, &second_sub_instance, &own_sub_instance}) {
+            for(auto i = sub_instance->get_vertices_begin(); i < sub_instance->get_vertices_end(); i++) {
+                ASSERT_EQ(sub_instance->get_reverse_mapping(sub_instance->get_mapping(i)), i);
+            }
+        }
+
+        ASSERT_EQ(first_sub_instance.get_reverse_mapping(2), 0);
+        ASSERT_EQ(second_sub_instance.get_reverse_mapping(59), 0);
+        ASSERT_EQ(own_sub_instance.get_reverse_mapping(104), 0);
+
+    }
+
+    TEST_F(InstanceTests, SharedMemoryInstance) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+        const auto name = "/cvrp-instance-test-" + std::to_string(getpid());
+
+        auto options = Instance::Options();
+        options.neighbors_num = 25;
+        auto instance = Instance(right_path, options);
+
+        ASSERT_EQ(instance.share(name), true);
+
+        // an existing object is only replaced on request
+        ASSERT_EQ(instance.share(name), false);
+        ASSERT_EQ(instance.share(name, true, true), true);
+
+        auto attach_options = Instance::Options();
+        attach_options.shared_memory = true;
+        auto first_instance = Instance(name, attach_options);
+        auto second_instance = Instance(name, attach_options);
+
+        // attached instances keep their view after the object has been removed
+        ASSERT_EQ(AbstractInstance::unshare(name), true);
+        ASSERT_EQ(Instance(name, attach_options).is_valid(), false);
+
+        for(auto attached_instance : {&first_instance, &second_instance}) {
+            ASSERT_EQ(attached_instance->is_valid(), true);
+            ASSERT_EQ(attached_instance->is_memory_mapped(), true);
+            ASSERT_EQ(attached_instance->get_vehicle_capacity(), instance.get_vehicle_capacity());
+            ASSERT_EQ(attached_instance->get_vertices_num(), instance.get_vertices_num());
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                ASSERT_EQ(attached_instance->get_demand(i), instance.get_demand(i));
+                for(auto j = instance.get_vertices_begin(); j < instance.get_vertices_end(); j++) {
+                    ASSERT_EQ(attached_instance->get_cost(i, j), instance.get_cost(i, j));
+                }
+                const auto neighbors = instance.get_neighbors_of(i);
+                const auto attached_neighbors = attached_instance->get_neighbors_of(i);
+                ASSERT_EQ(std::vector<int>(attached_neighbors.begin(), attached_neighbors.end()),
+                          std::vector<int>(neighbors.begin(), neighbors.end()));
+            }
+        }
+
+    }
+
+    TEST_F(InstanceTests, NeighborEntries) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+        std::string binary_path = "X-n106-k14-entries.bin";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 10;
+        auto instance = Instance(right_path, options);
+        instance.serialize(binary_path, AbstractInstance::SerializationFormat::Binary);
+        auto mapped_instance = Instance(binary_path);
+
+        auto subset = std::vector<int>({59, 32, 45, 11, 7, 1, 104, 80, 2, 3, 60});
+        auto sub_instance = SubInstance(instance, subset, 5);
+
+        for(auto current : std::vector<AbstractInstance*>({&instance, &mapped_instance, &sub_instance})) {
+            for(auto i = current->get_vertices_begin(); i < current->get_vertices_end(); i++) {
+                const auto neighbors = current->get_neighbors_of(i);
+                const auto entries = current->get_neighbor_entries_of(i);
+                ASSERT_EQ(entries.size(), neighbors.size());
+                ASSERT_EQ(neighbors.entries().begin(), entries.begin());
+                for(auto n = 0ul; n < entries.size(); n++) {
+                    ASSERT_EQ(entries[n].vertex, neighbors[n]);
+                    ASSERT_EQ(entries[n].cost, current->get_cost(i, entries[n].vertex));
+                }
+            }
+        }
+
+        std::remove(binary_path.c_str());
+
+    }
+
+    TEST_F(InstanceTests, VerticesOrdering) {
+
+        std::string right_path = "../../../instances/VRP_Instances_Belgium/Leuven1.txt";
+        std::string binary_path = "Leuven1-renumbered.bin";
+        std::string text_path = "Leuven1-renumbered.vrp";
+
+        auto options = Instance::Options();
+        options.neighbors_num = 10;
+        auto file_instance = Instance(right_path, options);
+
+        // distance between the indices of each vertex and of its nearest neighbor
+        const auto get_index_spread = [](const AbstractInstance &instance) {
+            auto spread = 0l;
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                spread += std::abs(instance.get_neighbors_of(i)[1] - i);
+            }
+            return spread;
+        };
+
+        for(auto ordering : {Instance::VerticesOrdering::Hilbert, Instance::VerticesOrdering::Morton}) {
+
+            options.vertices_ordering = ordering;
+            auto instance = Instance(right_path, options);
+
+            ASSERT_TRUE(instance.is_valid());
+            ASSERT_EQ(instance.get_external_id(instance.get_depot()), file_instance.get_depot());
+            ASSERT_LT(get_index_spread(instance), get_index_spread(file_instance) / 4);
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                const auto external_i = instance.get_external_id(i);
+                ASSERT_EQ(instance.get_internal_id(external_i), i);
+                ASSERT_EQ(instance.get_x_coordinate(i), file_instance.get_x_coordinate(external_i));
+                ASSERT_EQ(instance.get_y_coordinate(i), file_instance.get_y_coordinate(external_i));
+                ASSERT_EQ(instance.get_demand(i), file_instance.get_demand(external_i));
+                for(auto j = i; j < std::min(i + 50, instance.get_vertices_end()); j++) {
+                    ASSERT_EQ(instance.get_cost(i, j), file_instance.get_cost(external_i, instance.get_external_id(j)));
+                }
+            }
+
+            // the binary format keeps the identifiers, text formats list the vertices in the file order
+            instance.serialize(binary_path, AbstractInstance::SerializationFormat::Binary);
+            instance.serialize(text_path, AbstractInstance::SerializationFormat::TSPLIB);
+            auto mapped_instance = Instance(binary_path);
+            auto text_instance = Instance(text_path);
+
+            for(auto i = instance.get_vertices_begin(); i < instance.get_vertices_end(); i++) {
+                ASSERT_EQ(mapped_instance.get_external_id(i), instance.get_external_id(i));
+                ASSERT_EQ(mapped_instance.get_internal_id(instance.get_external_id(i)), i);
+                ASSERT_EQ(text_instance.get_demand(i), file_instance.get_demand(i));
+                ASSERT_NEAR(text_instance.get_x_coordinate(i), file_instance.get_x_coordinate(i), 1e-3f);
+            }
+
+        }
+
+        std::remove(binary_path.c_str());
+        std::remove(text_path.c_str());
+
+    }
+
+    TEST_F(InstanceTests, SubInstanceRetarget) {
+
+        std::string right_path = "../../../instances/X/X-n106-k14.vrp";
+
+        auto instance = Instance(right_path);
+
+        auto first_subset = std::vector<int>();
+        for(auto i = 1; i < 60; i++) {
+            first_subset.push_back(i);
+        }
+        auto second_subset = std::vector<int>({59, 32, 45, 11, 7, 1, 104, 80});
+
+        for(auto costs_storage : {SubInstance::CostsStorage::Root, SubInstance::CostsStorage::Matrix}) {
+
+            auto options = SubInstance::Options();
+            options.neighbors_num = 5;
+            options.costs_storage = costs_storage;
+
+            // shrinking and growing the sub-instance must give the same view as a fresh one
+            auto sub_instance = SubInstance(instance, first_subset, options);
+            for(auto subset : {&second_subset, &first_subset}) {
+
+                sub_instance.retarget(*subset);
+                auto fresh_sub_instance = SubInstance(instance, *subset, options);
+
+                ASSERT_EQ(sub_instance.get_vertices_num(), fresh_sub_instance.get_vertices_num());
+                ASSERT_EQ(sub_instance.get_customers_num(), fresh_sub_instance.get_customers_num());
+                ASSERT_EQ(sub_instance.has_local_costs(), fresh_sub_instance.has_local_costs());
+
+                for(auto i = sub_instance.get_vertices_begin(); i < sub_instance.get_vertices_end(); i++) {
+                    ASSERT_EQ(sub_instance.get_mapping(i), fresh_sub_instance.get_mapping(i));
+                    ASSERT_EQ(sub_instance.get_reverse_mapping(sub_instance.get_mapping(i)), i);
+                    ASSERT_EQ(sub_instance.get_demand(i), fresh_sub_instance.get_demand(i));
+                    for(auto j = sub_instance.get_vertices_begin(); j < sub_instance.get_vertices_end(); j++) {
+                        ASSERT_EQ(sub_instance.get_cost(i, j), fresh_sub_instance.get_cost(i, j));
+                    }
+                    const auto neighbors = sub_instance.get_neighbors_of(i);
+                    const auto fresh_neighbors = fresh_sub_instance.get_neighbors_of(i);
+                    ASSERT_EQ(std::vector<int>(neighbors.begin(), neighbors.end()),
+                              std::vector<int>(fresh_neighbors.begin(), fresh_neighbors.end()));
+                }
+
+                auto nearest = std::vector<int>();
+                auto fresh_nearest = std::vector<int>();
+                sub_instance.get_nearest_vertices(50.0f, 50.0f, 4, nearest);
+                fresh_sub_instance.get_nearest_vertices(50.0f, 50.0f, 4, fresh_nearest);
+                ASSERT_EQ(nearest, fresh_nearest);
+
+            }
+
+            // customers of the previous target are no longer mapped
+            sub_instance.retarget(second_subset);
+            ASSERT_EQ(sub_instance.get_reverse_mapping(2), 0);
+
+        }
+
+    }
+
 
 }
\ No newline at end of file
@@ -2,74 +2,398 @@
 // Created by acco on 5/29/18.
 //
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <utility>
 #include <macro.hpp>
 #include "Solution.hpp"
 #include <AbstractInstance.hpp>
+#include <Instance.hpp>
+#include <SubInstance.hpp>
 
 
-const int Solution::dummy_vertex = -1;
-const int Solution::dummy_route = 0;
+template<class InstanceType>
+const int BasicSolution<InstanceType>::dummy_vertex = -1;
+template<class InstanceType>
+const int BasicSolution<InstanceType>::dummy_route = 0;
 
-Solution::Solution(AbstractInstance &instance) :
+template<class InstanceType>
+BasicSolution<InstanceType>::BasicSolution(InstanceType &instance, bool change_tracking) :
         instance(instance),
         solution_cost(INFINITY),
         max_number_routes(instance.get_vertices_num() + 1),
         routes_pool(max_number_routes - 1, [](int index) { return index + 1; }),
-        depot_node({Solution::dummy_route, 0}),
+        depot_node({BasicSolution::dummy_route, 0}),
         routes_list(new RouteNode[max_number_routes]),
-        customers_list(new CustomerNode[instance.get_vertices_num()]) {
+        customers_list(new CustomerNode[instance.get_vertices_num()]),
+        unstaged_changes(instance.get_vertices_num()),
+        change_tracking(change_tracking),
+        synchronized_with(nullptr),
+        dirty_routes(max_number_routes),
+        dirty_vertices(instance.get_vertices_num()),
+        routes_pool_min_size(0),
+        unstaged_changes_shared_size(0),
+        in_transaction(false),
+        journaled_routes(max_number_routes),
+        journaled_vertices(instance.get_vertices_num()),
+        transaction_depot_node({BasicSolution::dummy_route, 0}),
+        transaction_solution_cost(0.0),
+        transaction_unstaged_changes_size(0),
+        recording_writes(false) {
 
     reset();
     
 }
 
 
-Solution::~Solution() {
+template<class InstanceType>
+BasicSolution<InstanceType>::~BasicSolution() {
+    desynchronize();
     delete[] customers_list;
     delete[] routes_list;
 }
 
-void Solution::copy(const Solution &source) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::copy(const BasicSolution &source) {
+
+    assert(max_number_routes == source.max_number_routes);
+    // moved-from solutions have no buffers, they may only be destroyed or move-assigned
+    assert(routes_list != nullptr && source.routes_list != nullptr);
+
+    desynchronize();
+    commit_transaction();
 
     routes_pool = source.routes_pool;
 
     depot_node = source.depot_node;
-    for (int i = 0; i < instance.get_vertices_num(); i++) {
-        customers_list[i] = source.customers_list[i];
-    }
-    for (int r = 0; r < instance.get_vertices_num(); r++) {
-        routes_list[r] = source.routes_list[r];
-    }
+    std::copy(source.customers_list, source.customers_list + instance.get_vertices_num(), customers_list);
+    std::copy(source.routes_list, source.routes_list + max_number_routes, routes_list);
     solution_cost = source.solution_cost;
 
     unstaged_changes = source.unstaged_changes;
+    change_tracking = source.change_tracking;
 
 }
 
-Solution &Solution::operator=(const Solution &source) {
+template<class InstanceType>
+BasicSolution<InstanceType> &BasicSolution<InstanceType>::operator=(const BasicSolution &source) {
 
-    copy(source);
+    if (this != &source) {
+        copy(source);
+    }
+
+    return *this;
+
+}
+
+template<class InstanceType>
+BasicSolution<InstanceType> &BasicSolution<InstanceType>::operator=(BasicSolution &&source) noexcept {
+
+    assert(&instance == &source.instance);
+
+    desynchronize();
+    source.desynchronize();
+
+    std::swap(solution_cost, source.solution_cost);
+    std::swap(routes_pool, source.routes_pool);
+    std::swap(depot_node, source.depot_node);
+    std::swap(routes_list, source.routes_list);
+    std::swap(customers_list, source.customers_list);
+    std::swap(unstaged_changes, source.unstaged_changes);
+    std::swap(change_tracking, source.change_tracking);
+    std::swap(dirty_routes, source.dirty_routes);
+    std::swap(dirty_vertices, source.dirty_vertices);
+    std::swap(in_transaction, source.in_transaction);
+    std::swap(routes_journal, source.routes_journal);
+    std::swap(vertices_journal, source.vertices_journal);
+    std::swap(routes_pool_journal, source.routes_pool_journal);
+    std::swap(journaled_routes, source.journaled_routes);
+    std::swap(journaled_vertices, source.journaled_vertices);
+    std::swap(transaction_depot_node, source.transaction_depot_node);
+    std::swap(transaction_solution_cost, source.transaction_solution_cost);
+    std::swap(transaction_unstaged_changes_size, source.transaction_unstaged_changes_size);
+    update_recording_writes();
+    source.update_recording_writes();
 
     return *this;
 
 }
 
-Solution::Solution(const Solution &source) :
+template<class InstanceType>
+BasicSolution<InstanceType>::BasicSolution(const BasicSolution &source) :
         instance(source.instance),
         solution_cost(INFINITY),
         max_number_routes(instance.get_vertices_num() + 1),
         routes_pool(max_number_routes - 1, [](int index) { return index + 1; }),
-        depot_node({Solution::dummy_route, 0}),
+        depot_node({BasicSolution::dummy_route, 0}),
         routes_list(new RouteNode[max_number_routes]),
-        customers_list(new CustomerNode[instance.get_vertices_num()]) {
+        customers_list(new CustomerNode[instance.get_vertices_num()]),
+        unstaged_changes(instance.get_vertices_num()),
+        change_tracking(source.change_tracking),
+        synchronized_with(nullptr),
+        dirty_routes(max_number_routes),
+        dirty_vertices(instance.get_vertices_num()),
+        routes_pool_min_size(0),
+        unstaged_changes_shared_size(0),
+        in_transaction(false),
+        journaled_routes(max_number_routes),
+        journaled_vertices(instance.get_vertices_num()),
+        transaction_depot_node({BasicSolution::dummy_route, 0}),
+        transaction_solution_cost(0.0),
+        transaction_unstaged_changes_size(0),
+        recording_writes(false) {
 
     copy(source);
 
 }
 
-void Solution::reset_route(const int route) {
+template<class InstanceType>
+BasicSolution<InstanceType>::BasicSolution(BasicSolution &&source) noexcept :
+        instance(source.instance),
+        solution_cost(source.solution_cost),
+        max_number_routes(source.max_number_routes),
+        routes_pool(std::move(source.routes_pool)),
+        depot_node(source.depot_node),
+        routes_list(source.routes_list),
+        customers_list(source.customers_list),
+        unstaged_changes(std::move(source.unstaged_changes)),
+        change_tracking(source.change_tracking),
+        synchronized_with(nullptr),
+        dirty_routes(std::move(source.dirty_routes)),
+        dirty_vertices(std::move(source.dirty_vertices)),
+        routes_pool_min_size(0),
+        unstaged_changes_shared_size(0),
+        in_transaction(source.in_transaction),
+        routes_journal(std::move(source.routes_journal)),
+        vertices_journal(std::move(source.vertices_journal)),
+        routes_pool_journal(std::move(source.routes_pool_journal)),
+        journaled_routes(std::move(source.journaled_routes)),
+        journaled_vertices(std::move(source.journaled_vertices)),
+        transaction_depot_node(source.transaction_depot_node),
+        transaction_solution_cost(source.transaction_solution_cost),
+        transaction_unstaged_changes_size(source.transaction_unstaged_changes_size),
+        recording_writes(in_transaction) {
+
+    source.in_transaction = false;
+    source.desynchronize();
+    source.routes_list = nullptr;
+    source.customers_list = nullptr;
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::copy_from(BasicSolution &source) {
+
+    assert(&instance == &source.instance);
+
+    if (this == &source) {
+        return;
+    }
+
+    if (!is_synchronized_with(source)) {
+        copy(source);
+        synchronize_with(source);
+        return;
+    }
+
+    commit_transaction();
+
+    // both solutions were identical at the last synchronization, thus they only differ where one of them changed
+    for (auto route : source.dirty_routes) {
+        routes_list[route] = source.routes_list[route];
+    }
+    for (auto route : dirty_routes) {
+        routes_list[route] = source.routes_list[route];
+    }
+    for (auto vertex : source.dirty_vertices) {
+        customers_list[vertex] = source.customers_list[vertex];
+    }
+    for (auto vertex : dirty_vertices) {
+        customers_list[vertex] = source.customers_list[vertex];
+    }
+
+    routes_pool.copy_from(source.routes_pool, std::min(routes_pool_min_size, source.routes_pool_min_size));
+
+    depot_node = source.depot_node;
+    solution_cost = source.solution_cost;
+
+    // the unstaged changes only grow between two commits, thus they still share the prefix of the synchronization
+    const auto shared_changes = std::min(unstaged_changes_shared_size, source.unstaged_changes_shared_size);
+    unstaged_changes.truncate(shared_changes);
+    for (auto vertex = source.unstaged_changes.begin() + shared_changes; vertex != source.unstaged_changes.end(); vertex++) {
+        unstaged_changes.insert(*vertex);
+    }
+    change_tracking = source.change_tracking;
+
+    synchronize_with(source);
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::synchronize_with(BasicSolution &other) {
+
+    if (synchronized_with != &other) {
+        desynchronize();
+        other.desynchronize();
+        synchronized_with = &other;
+        other.synchronized_with = this;
+        update_recording_writes();
+        other.update_recording_writes();
+    }
+
+    dirty_routes.clear();
+    dirty_vertices.clear();
+    other.dirty_routes.clear();
+    other.dirty_vertices.clear();
+
+    routes_pool_min_size = routes_pool.size();
+    other.routes_pool_min_size = other.routes_pool.size();
+
+    unstaged_changes_shared_size = unstaged_changes.size();
+    other.unstaged_changes_shared_size = other.unstaged_changes.size();
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::desynchronize() {
+
+    if (synchronized_with) {
+        synchronized_with->synchronized_with = nullptr;
+        synchronized_with->update_recording_writes();
+        synchronized_with = nullptr;
+        update_recording_writes();
+    }
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::update_recording_writes() {
+    recording_writes = synchronized_with != nullptr || in_transaction;
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::record_route_write(const int route) {
+
+    if (synchronized_with) {
+        dirty_routes.insert(route);
+    }
+
+    if (in_transaction && !journaled_routes.contains(route)) {
+        journaled_routes.insert(route);
+        routes_journal.emplace_back(route, routes_list[route]);
+    }
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::record_vertex_write(const int vertex) {
+
+    if (synchronized_with) {
+        dirty_vertices.insert(vertex);
+    }
+
+    if (in_transaction && !journaled_vertices.contains(vertex)) {
+        journaled_vertices.insert(vertex);
+        vertices_journal.emplace_back(vertex, customers_list[vertex]);
+    }
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::begin_transaction() {
+
+    assert(!in_transaction);
+
+    in_transaction = true;
+    update_recording_writes();
+
+    transaction_depot_node = depot_node;
+    transaction_solution_cost = solution_cost;
+    transaction_unstaged_changes_size = unstaged_changes.size();
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::rollback() {
+
+    assert(in_transaction);
+
+    // close the transaction first so that restoring the nodes is not journaled
+    in_transaction = false;
+    update_recording_writes();
+
+    for (const auto &entry : routes_journal) {
+        touch_route(entry.first);
+        routes_list[entry.first] = entry.second;
+    }
+    for (const auto &entry : vertices_journal) {
+        touch_vertex(entry.first);
+        customers_list[entry.first] = entry.second;
+    }
+
+    // undo the routes pool operations in reverse order
+    for (auto operation = routes_pool_journal.rbegin(); operation != routes_pool_journal.rend(); operation++) {
+        if (operation->requested) {
+            routes_pool.push(operation->route);
+        } else {
+            routes_pool.get();
+            if (synchronized_with) {
+                routes_pool_min_size = std::min(routes_pool_min_size, routes_pool.size());
+            }
+        }
+    }
+
+    depot_node = transaction_depot_node;
+    solution_cost = transaction_solution_cost;
+
+    if (transaction_unstaged_changes_size >= 0) {
+        // the unstaged changes only grew since begin_transaction
+        unstaged_changes.truncate(transaction_unstaged_changes_size);
+        unstaged_changes_shared_size = std::min(unstaged_changes_shared_size, unstaged_changes.size());
+    } else {
+        // committed within the transaction, thus the restored vertices changed again
+        if (!routes_journal.empty()) {
+            track_change(instance.get_depot());
+        }
+        for (const auto &entry : vertices_journal) {
+            track_change(entry.first);
+        }
+    }
+
+    commit_transaction();
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::commit_transaction() {
+
+    in_transaction = false;
+    update_recording_writes();
+
+    routes_journal.clear();
+    vertices_journal.clear();
+    routes_pool_journal.clear();
+    journaled_routes.clear();
+    journaled_vertices.clear();
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::track_solution_vertices() {
+
+    for (auto route = depot_node.first_route; route != BasicSolution::dummy_route; route = routes_list[route].next) {
+        track_change(instance.get_depot());
+        for (auto curr = routes_list[route].first_customer; curr != instance.get_depot(); curr = customers_list[curr].next) {
+            track_change(curr);
+        }
+    }
+
+}
+
+template<class InstanceType>
+void BasicSolution<InstanceType>::reset_route(const int route) {
+    touch_route(route);
     routes_list[route].load = 0;
     routes_list[route].size = 0;
     routes_list[route].cost = 0.0f;
@@ -77,19 +401,25 @@ void Solution::reset_route(const int route) {
     routes_list[route].last_customer = instance.get_depot();
 }
 
-void Solution::reset_vertex(const int customer) {
-    customers_list[customer].next = Solution::dummy_vertex;
-    customers_list[customer].prev = Solution::dummy_vertex;
-    customers_list[customer].route_ptr = Solution::dummy_route;
+template<class InstanceType>
+void BasicSolution<InstanceType>::reset_vertex(const int customer) {
+    touch_vertex(customer);
+    customers_list[customer].next = BasicSolution::dummy_vertex;
+    customers_list[customer].prev = BasicSolution::dummy_vertex;
+    customers_list[customer].route_ptr = BasicSolution::dummy_route;
 }
 
-void Solution::reset() {
+template<class InstanceType>
+void BasicSolution<InstanceType>::reset() {
+
+    desynchronize();
+    commit_transaction();
 
     solution_cost = 0.0;
 
     routes_pool.reset();
 
-    depot_node.first_route = Solution::dummy_route;
+    depot_node.first_route = BasicSolution::dummy_route;
     depot_node.num_routes = 0;
 
     for (int r = 0; r < max_number_routes; r++) {
@@ -102,32 +432,47 @@ void Solution::reset() {
 
 }
 
-float Solution::get_cost() const {
+template<class InstanceType>
+float BasicSolution<InstanceType>::get_cost() const {
 
     return static_cast<float>(solution_cost);
 
 }
 
-int Solution::get_routes_num() const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_routes_num() const {
     return depot_node.num_routes;
 }
 
-int Solution::request_route() {
+template<class InstanceType>
+int BasicSolution<InstanceType>::request_route() {
 
     assert(!routes_pool.is_empty());
 
     const auto route = routes_pool.get();
 
+    if (synchronized_with) {
+        routes_pool_min_size = std::min(routes_pool_min_size, routes_pool.size());
+    }
+    if (in_transaction) {
+        routes_pool_journal.push_back({route, true});
+    }
+
     return route;
 }
 
-int Solution::build_one_customer_route(const int customer) {
+template<class InstanceType>
+int BasicSolution<InstanceType>::build_one_customer_route(const int customer) {
 
     assert(!is_customer_in_solution(customer));
     assert(customer != instance.get_depot());
 
     const auto route = request_route();
 
+    touch_vertex(customer);
+    touch_route(route);
+    touch_route(depot_node.first_route);
+
     customers_list[customer].prev = instance.get_depot();
     customers_list[customer].next = instance.get_depot();
     customers_list[customer].route_ptr = route;
@@ -136,7 +481,7 @@ int Solution::build_one_customer_route(const int customer) {
     const auto next_route = depot_node.first_route;
     routes_list[route].next = next_route;                  // copy the previous head in the next
     depot_node.first_route = route;                       // and set the new head
-    routes_list[route].prev = Solution::dummy_route;      // since it is an head insertion
+    routes_list[route].prev = BasicSolution::dummy_route;      // since it is an head insertion
     routes_list[next_route].prev = route;                  // set the prev of the next route as this new route
 
     depot_node.num_routes++;
@@ -149,17 +494,19 @@ int Solution::build_one_customer_route(const int customer) {
 
     solution_cost += routes_list[route].cost;
 
-    unstaged_changes.insert(customer);
+    track_change(customer);
 
     return route;
 }
 
-int Solution::get_route_index(const int customer) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_index(const int customer) const {
     assert(customer != instance.get_depot());
     return customers_list[customer].route_ptr;
 }
 
-int Solution::get_route_index(const int vertex, const int fallback) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_index(const int vertex, const int fallback) const {
     if (unlikely(vertex == instance.get_depot())) {
         return customers_list[fallback].route_ptr;
     } else {
@@ -167,23 +514,28 @@ int Solution::get_route_index(const int vertex, const int fallback) const {
     }
 }
 
-int Solution::get_route_load(const int route) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_load(const int route) const {
     return routes_list[route].load;
 }
 
-int Solution::get_first_route() const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_first_route() const {
     return depot_node.first_route;
 }
 
-int Solution::get_next_route(const int route) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_next_route(const int route) const {
     return routes_list[route].next;
 }
 
-bool Solution::is_route_empty(const int route) const {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::is_route_empty(const int route) const {
     return routes_list[route].load == 0;
 }
 
-int Solution::get_next_vertex(const int route, const int vertex) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_next_vertex(const int route, const int vertex) const {
 
     assert(contains_vertex(route, vertex));
 
@@ -195,7 +547,8 @@ int Solution::get_next_vertex(const int route, const int vertex) const {
 
 }
 
-int Solution::get_prev_vertex(const int route, const int vertex) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_prev_vertex(const int route, const int vertex) const {
 
     assert(contains_vertex(route, vertex));
 
@@ -207,48 +560,59 @@ int Solution::get_prev_vertex(const int route, const int vertex) const {
 
 }
 
-int Solution::get_prev_vertex(const int customer) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_prev_vertex(const int customer) const {
     assert(customer != instance.get_depot());
     return customers_list[customer].prev;
 }
 
-int Solution::get_next_vertex(const int customer) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_next_vertex(const int customer) const {
     assert(customer != instance.get_depot());
     return customers_list[customer].next;
 }
 
-void Solution::set_next_vertex_ptr(const int route, const int vertex, const int next) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::set_next_vertex_ptr(const int route, const int vertex, const int next) {
     if (unlikely(vertex == instance.get_depot())) {
+        touch_route(route);
         routes_list[route].first_customer = next;
     } else {
+        touch_vertex(vertex);
         customers_list[vertex].next = next;
     }
 }
 
-void Solution::set_prev_vertex_ptr(const int route, const int vertex, const int prev) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::set_prev_vertex_ptr(const int route, const int vertex, const int prev) {
     if (unlikely(vertex == instance.get_depot())) {
+        touch_route(route);
         routes_list[route].last_customer = prev;
     } else {
+        touch_vertex(vertex);
         customers_list[vertex].prev = prev;
     }
 }
 
-float Solution::remove_vertex(const int route, const int vertex) {
+template<class InstanceType>
+float BasicSolution<InstanceType>::remove_vertex(const int route, const int vertex) {
 
     if (unlikely(vertex == instance.get_depot())) {
 
         const auto next = routes_list[route].first_customer;
         const auto prev = routes_list[route].last_customer;
 
-        unstaged_changes.insert(vertex);
-        unstaged_changes.insert(prev);
-        unstaged_changes.insert(next);
+        track_change(vertex);
+        track_change(prev);
+        track_change(next);
+
+        touch_route(route);
         
         set_prev_vertex_ptr(route, next, prev);
         set_next_vertex_ptr(route, prev, next);
 
-        routes_list[route].first_customer = Solution::dummy_vertex;
-        routes_list[route].last_customer = Solution::dummy_vertex;
+        routes_list[route].first_customer = BasicSolution::dummy_vertex;
+        routes_list[route].last_customer = BasicSolution::dummy_vertex;
 
         const auto delta = +instance.get_cost(prev, next) - instance.get_cost(prev, vertex) - instance.get_cost(vertex, next);
 
@@ -266,9 +630,13 @@ float Solution::remove_vertex(const int route, const int vertex) {
         const auto next = customers_list[vertex].next;
         const auto prev = customers_list[vertex].prev;
 
-        unstaged_changes.insert(vertex);
-        unstaged_changes.insert(prev);
-        unstaged_changes.insert(next);
+        track_change(vertex);
+        track_change(prev);
+        track_change(next);
+
+        touch_route(route);
+        touch_vertex(prev);
+        touch_vertex(next);
 
         if (vertex == routes_list[route].first_customer) {
             routes_list[route].first_customer = next;
@@ -299,24 +667,31 @@ float Solution::remove_vertex(const int route, const int vertex) {
 
 }
 
-int Solution::get_first_customer(const int route) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_first_customer(const int route) const {
     return routes_list[route].first_customer;
 }
 
-int Solution::get_last_customer(const int route) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_last_customer(const int route) const {
     return routes_list[route].last_customer;
 }
 
-void Solution::remove_route(const int route) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::remove_route(const int route) {
     assert(is_route_empty(route));
     release_route(route);
 }
 
-void Solution::release_route(const int route) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::release_route(const int route) {
 
     const auto prevRoute = routes_list[route].prev;
     const auto nextRoute = routes_list[route].next;
 
+    touch_route(prevRoute);
+    touch_route(nextRoute);
+
     routes_list[prevRoute].next = nextRoute;
     routes_list[nextRoute].prev = prevRoute;
     depot_node.num_routes--;
@@ -330,26 +705,35 @@ void Solution::release_route(const int route) {
 
     routes_pool.push(route);
 
+    if (in_transaction) {
+        routes_pool_journal.push_back({route, false});
+    }
+
 }
 
-void Solution::insert_vertex_before(const int route, const int where, const int vertex) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::insert_vertex_before(const int route, const int where, const int vertex) {
 
     assert(where != vertex);
 
     if (unlikely(vertex == instance.get_depot())) {
 
-        assert(routes_list[route].first_customer == Solution::dummy_vertex);
-        assert(routes_list[route].last_customer == Solution::dummy_vertex);
+        assert(routes_list[route].first_customer == BasicSolution::dummy_vertex);
+        assert(routes_list[route].last_customer == BasicSolution::dummy_vertex);
 
         assert(where != instance.get_depot());
 
         const auto prev = customers_list[where].prev;
         
-        unstaged_changes.insert(prev);
-        unstaged_changes.insert(where);
+        track_change(prev);
+        track_change(where);
 
         assert(prev != instance.get_depot());
 
+        touch_route(route);
+        touch_vertex(prev);
+        touch_vertex(where);
+
         routes_list[route].first_customer = where;
         routes_list[route].last_customer = prev;
 
@@ -372,9 +756,12 @@ void Solution::insert_vertex_before(const int route, const int where, const int
         const auto prev = get_prev_vertex(route, where);
         //insert vertex between prev and next
 
-        unstaged_changes.insert(prev);
-        unstaged_changes.insert(where);
+        track_change(prev);
+        track_change(where);
         
+        touch_route(route);
+        touch_vertex(vertex);
+
         // vertex for sure is not the root of route
         customers_list[vertex].next = where;
         customers_list[vertex].prev = prev;
@@ -395,20 +782,21 @@ void Solution::insert_vertex_before(const int route, const int where, const int
 
 }
 
-void Solution::reverse_route_path(const int route, const int vertex_begin, const int vertex_end) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::reverse_route_path(const int route, const int vertex_begin, const int vertex_end) {
 
     assert(vertex_begin != vertex_end);
 
     const auto pre = get_prev_vertex(route, vertex_begin);
     const auto stop = get_next_vertex(route, vertex_end);
 
-    unstaged_changes.insert(pre);
-    unstaged_changes.insert(stop);
+    track_change(pre);
+    track_change(stop);
 
     auto curr = vertex_begin;
     do {
 
-        unstaged_changes.insert(curr);
+        track_change(curr);
          
         const auto prev = get_prev_vertex(route, curr);
         const auto next = get_next_vertex(route, curr);
@@ -438,11 +826,13 @@ void Solution::reverse_route_path(const int route, const int vertex_begin, const
 
     solution_cost += delta;
 
+    touch_route(route);
     routes_list[route].cost += delta;
 
 }
 
-int Solution::append_route(const int route, const int route_to_append) {
+template<class InstanceType>
+int BasicSolution<InstanceType>::append_route(const int route, const int route_to_append) {
 
     const auto route_end = routes_list[route].last_customer;
     const auto route_to_append_start = routes_list[route_to_append].first_customer;
@@ -456,6 +846,10 @@ int Solution::append_route(const int route, const int route_to_append) {
 
     solution_cost += delta;
 
+    touch_route(route);
+    touch_vertex(route_end);
+    touch_vertex(route_to_append_start);
+
     customers_list[route_end].next = route_to_append_start;
     customers_list[route_to_append_start].prev = route_end;
 
@@ -465,12 +859,13 @@ int Solution::append_route(const int route, const int route_to_append) {
 
     routes_list[route].cost += routes_list[route_to_append].cost + delta;
 
-    unstaged_changes.insert(route_end);
+    track_change(route_end);
     
     for (auto curr = route_to_append_start; curr != instance.get_depot(); curr = customers_list[curr].next) {
+        touch_vertex(curr);
         customers_list[curr].route_ptr = route;
 
-        unstaged_changes.insert(curr);
+        track_change(curr);
         
     }
 
@@ -479,34 +874,39 @@ int Solution::append_route(const int route, const int route_to_append) {
     return route;
 }
 
-std::string Solution::to_string(const int route) const {
+template<class InstanceType>
+std::string BasicSolution<InstanceType>::to_string(const int route) const {
     std::string str;
     str += "[" + std::to_string(route) + "] ";
-    str += std::to_string(instance.get_depot()) + " ";
+    str += std::to_string(instance.get_external_id(instance.get_depot())) + " ";
     for (int curr = routes_list[route].first_customer; curr != instance.get_depot(); curr = customers_list[curr].next) {
-        str += std::to_string(curr) + " ";
+        str += std::to_string(instance.get_external_id(curr)) + " ";
     }
-    str += std::to_string(instance.get_depot());
+    str += std::to_string(instance.get_external_id(instance.get_depot()));
     return str;
 }
 
-void Solution::print(const int route) const {
+template<class InstanceType>
+void BasicSolution<InstanceType>::print(const int route) const {
     std::cout << to_string(route) << " (" << get_route_load(route) << ") " << get_route_cost(route) << "\n";
 }
 
-void Solution::print() const {
-    for (auto route = depot_node.first_route; route != Solution::dummy_route; route = routes_list[route].next) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::print() const {
+    for (auto route = depot_node.first_route; route != BasicSolution::dummy_route; route = routes_list[route].next) {
         print(route);
     }
     std::cout << "Solution cost = " << solution_cost << "\n";
 }
 
-void Solution::update_cumulative_route_loads(const int route) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::update_cumulative_route_loads(const int route) {
 
     assert(!is_route_empty(route));
 
     auto prev = routes_list[route].first_customer;
 
+    touch_vertex(prev);
     customers_list[prev].load_before = instance.get_demand(prev);
     customers_list[prev].load_after = routes_list[route].load;
 
@@ -514,6 +914,7 @@ void Solution::update_cumulative_route_loads(const int route) {
 
     while (curr != instance.get_depot()) {
 
+        touch_vertex(curr);
         customers_list[curr].load_before = customers_list[prev].load_before + instance.get_demand(curr);
         customers_list[curr].load_after = customers_list[prev].load_after - instance.get_demand(prev);
 
@@ -524,32 +925,38 @@ void Solution::update_cumulative_route_loads(const int route) {
 
 }
 
-int Solution::get_route_load_before_included(const int customer) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_load_before_included(const int customer) const {
     assert(customer != instance.get_depot());
     return customers_list[customer].load_before;
 }
 
-int Solution::get_route_load_after_included(const int customer) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_load_after_included(const int customer) const {
     assert(customer != instance.get_depot());
     return customers_list[customer].load_after;
 }
 
-bool Solution::is_route_in_solution(const int route) const {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::is_route_in_solution(const int route) const {
     return routes_list[route].first_customer != instance.get_depot() &&
            routes_list[route].last_customer != instance.get_depot();
 }
 
-bool Solution::is_customer_in_solution(const int customer) const {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::is_customer_in_solution(const int customer) const {
     assert(customer != instance.get_depot());
-    return customers_list[customer].route_ptr != Solution::dummy_route;
+    return customers_list[customer].route_ptr != BasicSolution::dummy_route;
 }
 
-bool Solution::contains_vertex(const int route, const int vertex) const {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::contains_vertex(const int route, const int vertex) const {
     assert(vertex >= instance.get_vertices_begin() && vertex < instance.get_vertices_end() && route >= 0 && route < max_number_routes);
     return customers_list[vertex].route_ptr == route || vertex == instance.get_depot();
 }
 
-bool Solution::is_feasible() {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::is_feasible() {
     bool partial = false;
     bool error = false;
     std::vector<int> unRoutedCustomers;
@@ -560,7 +967,7 @@ bool Solution::is_feasible() {
      */
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
 
-        if (customers_list[i].prev != Solution::dummy_vertex) {
+        if (customers_list[i].prev != BasicSolution::dummy_vertex) {
             if (customers_list[i].prev == instance.get_depot() &&
                 routes_list[customers_list[i].route_ptr].first_customer != i) {
                 std::cerr << "[ error ]\tcustomer " << i << " from route " << customers_list[i].route_ptr
@@ -589,8 +996,8 @@ bool Solution::is_feasible() {
             partial = true;
             unRoutedCustomers.push_back(i);
         }
-        if ((customers_list[i].next == Solution::dummy_vertex && customers_list[i].prev != Solution::dummy_vertex) ||
-            (customers_list[i].prev == Solution::dummy_vertex && customers_list[i].next != Solution::dummy_vertex)) {
+        if ((customers_list[i].next == BasicSolution::dummy_vertex && customers_list[i].prev != BasicSolution::dummy_vertex) ||
+            (customers_list[i].prev == BasicSolution::dummy_vertex && customers_list[i].next != BasicSolution::dummy_vertex)) {
             std::cerr << "[ error ] Node " << i << " not completely removed.\n";
             error = true;
         }
@@ -600,8 +1007,8 @@ bool Solution::is_feasible() {
     std::vector<int> nextCount(instance.get_vertices_num(), 0);
 
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
-        if (customers_list[i].prev == Solution::dummy_vertex ||
-            customers_list[i].next == Solution::dummy_vertex) { continue; }
+        if (customers_list[i].prev == BasicSolution::dummy_vertex ||
+            customers_list[i].next == BasicSolution::dummy_vertex) { continue; }
         prevCount[customers_list[i].prev]++;
         nextCount[customers_list[i].next]++;
     }
@@ -618,7 +1025,7 @@ bool Solution::is_feasible() {
     }
 
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
-        if (customers_list[i].route_ptr == Solution::dummy_route) { continue; }
+        if (customers_list[i].route_ptr == BasicSolution::dummy_route) { continue; }
         if (routes_list[customers_list[i].route_ptr].first_customer == instance.get_depot()) {
             std::cerr << "[ error ] Node " << i << " belongs to route " << customers_list[i].route_ptr
                       << " which has no starting point.\n";
@@ -663,7 +1070,7 @@ bool Solution::is_feasible() {
 
 
     for (int i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
-        if (customers_list[i].route_ptr == Solution::dummy_route) { continue; }
+        if (customers_list[i].route_ptr == BasicSolution::dummy_route) { continue; }
         const int route = customers_list[i].route_ptr;
         bool found = false;
         for (int curr = routes_list[route].first_customer; curr != instance.get_depot(); curr = customers_list[curr].next) {
@@ -681,7 +1088,7 @@ bool Solution::is_feasible() {
     }
 
     double cost = 0;
-    for (auto route = get_first_route(); route != Solution::dummy_route; route = get_next_route(route)) {
+    for (auto route = get_first_route(); route != BasicSolution::dummy_route; route = get_next_route(route)) {
         auto route_cost = 0.0;
         route_cost += instance.get_cost(instance.get_depot(), get_first_customer(route));
         for (auto curr = get_first_customer(route); curr != instance.get_depot(); curr = get_next_vertex(curr)) {
@@ -709,9 +1116,9 @@ bool Solution::is_feasible() {
                   << cost - get_cost() << "\n";
     }
 
-    for (auto route = get_first_route(); route != Solution::dummy_route; route = get_next_route(route)) {
-        if (routes_list[route].last_customer == Solution::dummy_vertex ||
-            routes_list[route].first_customer == Solution::dummy_vertex) {
+    for (auto route = get_first_route(); route != BasicSolution::dummy_route; route = get_next_route(route)) {
+        if (routes_list[route].last_customer == BasicSolution::dummy_vertex ||
+            routes_list[route].first_customer == BasicSolution::dummy_vertex) {
             error = true;
             std::cerr << "[ error ]\t";
             std::cerr.precision(6);
@@ -722,7 +1129,7 @@ bool Solution::is_feasible() {
     }
 
     auto computed_route = 0.0f;
-    for(auto route = get_first_route(); route != Solution::dummy_route; route = get_next_route(route)) {
+    for(auto route = get_first_route(); route != BasicSolution::dummy_route; route = get_next_route(route)) {
 
         computed_route += get_route_cost(route);
 
@@ -755,22 +1162,16 @@ bool Solution::is_feasible() {
 
 }
 
-int Solution::get_route_size(const int route) const {
+template<class InstanceType>
+int BasicSolution<InstanceType>::get_route_size(const int route) const {
     return routes_list[route].size;
 }
 
-float Solution::get_route_cost(const int route) const {
+template<class InstanceType>
+float BasicSolution<InstanceType>::get_route_cost(const int route) const {
     return routes_list[route].cost;
 }
 
-
-
-
-
-
-
-
-
-
-
-
+template class BasicSolution<AbstractInstance>;
+template class BasicSolution<Instance>;
+template class BasicSolution<SubInstance>;
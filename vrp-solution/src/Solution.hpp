@@ -6,23 +6,29 @@
 #define VRP_SOLUTION_HPP
 
 #include <FixedSizeValueStack.hpp>
+#include <SparseIntSet.hpp>
 #include <vector>
 #include <stack>
 #include <random>
-#include <unordered_set>
+#include <utility>
 
 class AbstractInstance;
 
 /**
- * Class used to represent and manage a solution.
+ * Class used to represent and manage a solution. The instance type the solution refers to is a template parameter.
+ * By default it is AbstractInstance and every instance access is a virtual call, while a concrete final class such as
+ * Instance or SubInstance makes the calls statically dispatched, so that the compiler can inline the cost and demand
+ * lookups within the solution operations and the caller loops. The Solution alias is the type-erased default.
+ * @tparam InstanceType class of the instance, AbstractInstance or one of its final implementations
  */
-class Solution {
+template<class InstanceType = AbstractInstance>
+class BasicSolution {
 
     /**
      * Deep copy of a source solution.
      * @param source the source solution
      */
-    void copy(const Solution &source);
+    void copy(const BasicSolution &source);
 
 public:
 
@@ -40,26 +46,81 @@ public:
     /**
      * Solution constructor. Note that the instance reference ownership is not transferred.
      * @param instance instance
+     * @param change_tracking whether the modified vertices are tracked, see set_change_tracking
      */
-    explicit Solution(AbstractInstance &instance);
+    explicit BasicSolution(InstanceType &instance, bool change_tracking = true);
 
     /**
      * Generate a new solution from a the deep copy of a source solution.
      * @param source solution
      */
-    Solution(const Solution &source);
+    BasicSolution(const BasicSolution &source);
+
+    /**
+     * Generate a new solution by taking over the buffers of a source solution.
+     * The source solution is left without buffers: moved-from solutions may only be destroyed or move-assigned.
+     * @param source solution
+     */
+    BasicSolution(BasicSolution &&source) noexcept;
 
     /**
      * Solution destructor.
      */
-    virtual ~Solution();
+    virtual ~BasicSolution();
+
+    /**
+     * Deep copy a source solution. Neither solution may be a moved-from one.
+     * @param source solution
+     * @return solution
+     */
+    BasicSolution &operator=(const BasicSolution &source);
 
     /**
-     * Deep copy a source solution
+     * Exchange the content with a source solution defined over the same instance, without any allocation.
+     * The source solution is left holding the previous content of this one.
      * @param source solution
      * @return solution
      */
-    Solution &operator=(const Solution &source);
+    BasicSolution &operator=(BasicSolution &&source) noexcept;
+
+    /**
+     * Copy a source solution defined over the same instance by transferring only the routes and vertices modified
+     * in the two solutions since their last copy_from. The first call, or any call after one of the two solutions
+     * was synchronized with a third one, reset, built or assigned, performs a full copy.
+     * @param source solution, which records the new synchronization point as well
+     */
+    void copy_from(BasicSolution &source);
+
+    /**
+     * @param other solution
+     * @return whether the next copy_from between this solution and other only transfers their modifications
+     */
+    inline bool is_synchronized_with(const BasicSolution &other) const {
+        return synchronized_with == &other;
+    }
+
+    /**
+     * Start recording the modifications of the solution, so that they can be reverted by rollback in time
+     * proportional to the number of modified routes and vertices. Transactions cannot be nested.
+     */
+    void begin_transaction();
+
+    /**
+     * Revert the solution, together with its unstaged changes, to its state at begin_transaction and close the
+     * transaction.
+     */
+    void rollback();
+
+    /**
+     * Accept the modifications performed since begin_transaction and close the transaction. Note that reset,
+     * construction methods and the assignment of a whole solution commit the open transaction as well.
+     */
+    void commit_transaction();
+
+    /**
+     * @return whether a transaction is open
+     */
+    inline bool is_in_transaction() const { return in_transaction; }
 
     /**
      * Reset a solution.
@@ -207,7 +268,7 @@ public:
     int append_route(int route, int route_to_append);
 
     /**
-     * Generates a string representation of a given route.
+     * Generates a string representation of a given route, in which vertices are identified as in the instance file.
      * @param route
      * @return string
      */
@@ -303,19 +364,37 @@ public:
     float get_route_cost(int route) const;
 
     /**
-     * Clear the set of recently modified vertices.
+     * Clear the set of recently modified vertices in constant time.
      */
-    inline void commit() { unstaged_changes.clear(); }
+    inline void commit() {
+        unstaged_changes.clear();
+        unstaged_changes_shared_size = 0;
+        transaction_unstaged_changes_size = -1;
+    }
 
     /**
      * Returns the recently modified vertices.
      * Note that it is not safe to perform any operations while iterating the returned set.
-     * @return set
+     * @return set, whose elements are listed in a contiguous range
+     */
+    inline const SparseIntSet& get_unstaged_changes() const { return unstaged_changes; }
+
+    /**
+     * Enables or disables the tracking of the modified vertices. While disabled, the solution operations do not
+     * record their vertices, which saves their cost to algorithms that never read the unstaged changes. The changes
+     * recorded so far are kept. Construction methods such as clarke_and_wright and load always disable it while
+     * running and, if enabled, mark all the vertices of the built solution as changed at the end.
+     * @param enabled whether the changes are tracked
+     */
+    inline void set_change_tracking(bool enabled) { change_tracking = enabled; }
+
+    /**
+     * @return whether the modified vertices are tracked
      */
-    inline const std::unordered_set<int>& get_unstaged_changes() const { return unstaged_changes; }
+    inline bool is_tracking_changes() const { return change_tracking; }
 
     /**
-     * Load an existing solution.
+     * Load an existing solution, whose vertices are identified as in the instance file.
      * @param path
      * @return whether the loading has been successful
      */
@@ -346,7 +425,7 @@ private:
         float cost;
     };
 
-    AbstractInstance &instance;
+    InstanceType &instance;
     double solution_cost;
     const int max_number_routes;
     FixedSizeValueStack<int> routes_pool;
@@ -360,11 +439,70 @@ private:
     void set_prev_vertex_ptr(int route, int vertex, int prev);
     int request_route();
     void release_route(int route);
+    void track_solution_vertices();
+
+    inline void track_change(int vertex) {
+        if(change_tracking) {
+            unstaged_changes.insert(vertex);
+        }
+    }
+
+    SparseIntSet unstaged_changes;
+    bool change_tracking;
+
+    // modifications since the last copy_from with the synchronized solution
+    BasicSolution *synchronized_with;
+    SparseIntSet dirty_routes;
+    SparseIntSet dirty_vertices;
+    int routes_pool_min_size;
+    int unstaged_changes_shared_size;
+
+    // undo journal of the open transaction, holding the nodes as they were before their first modification
+    struct RoutesPoolOperation {
+        int route;
+        bool requested;
+    };
 
-    std::unordered_set<int> unstaged_changes;
+    bool in_transaction;
+    std::vector<std::pair<int, RouteNode>> routes_journal;
+    std::vector<std::pair<int, CustomerNode>> vertices_journal;
+    std::vector<RoutesPoolOperation> routes_pool_journal;
+    SparseIntSet journaled_routes;
+    SparseIntSet journaled_vertices;
+    DepotNode transaction_depot_node;
+    double transaction_solution_cost;
+    int transaction_unstaged_changes_size;
+
+    // whether the node writes are recorded, either for copy_from or for the open transaction
+    bool recording_writes;
+
+    void synchronize_with(BasicSolution &other);
+    void desynchronize();
+    void update_recording_writes();
+
+    // kept out of line so that the disabled hooks cost a single test in the modification methods
+    __attribute__((noinline)) void record_route_write(int route);
+    __attribute__((noinline)) void record_vertex_write(int vertex);
+
+    // to be called before any write to the route node
+    inline void touch_route(int route) {
+        if(recording_writes) {
+            record_route_write(route);
+        }
+    }
+
+    // to be called before any write to the customer node
+    inline void touch_vertex(int vertex) {
+        if(recording_writes) {
+            record_vertex_write(vertex);
+        }
+    }
 
 };
 
-
+/**
+ * Solution accessing the instance through the AbstractInstance interface.
+ */
+using Solution = BasicSolution<>;
 
 #endif //VRP_SOLUTION_HPP
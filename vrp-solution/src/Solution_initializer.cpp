@@ -7,12 +7,18 @@
 #include <iostream>
 #include "Solution.hpp"
 #include "Instance.hpp"
+#include "SubInstance.hpp"
 
 
-void Solution::clarke_and_wright(float lambda, int neighbors_num) {
+template<class InstanceType>
+void BasicSolution<InstanceType>::clarke_and_wright(float lambda, int neighbors_num) {
 
     this->reset();
 
+    // every vertex is touched several times while merging the routes, it is marked once at the end instead
+    const auto tracking = this->change_tracking;
+    this->change_tracking = false;
+
     for (auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
         this->build_one_customer_route(i);
     }
@@ -32,15 +38,17 @@ void Solution::clarke_and_wright(float lambda, int neighbors_num) {
 
     for(auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i++) {
 
-        for(auto n = 1u, added=0u; added < static_cast<unsigned int>(neighbors_num) && n < instance.get_neighbors_of(i).size(); n++) {
+        const auto neighbors = instance.get_neighbor_entries_of(i);
+
+        for(auto n = 1u, added=0u; added < static_cast<unsigned int>(neighbors_num) && n < neighbors.size(); n++) {
 
-            const auto j = instance.get_neighbors_of(i)[n];
+            const auto j = neighbors[n].vertex;
             // avoid symmetries and depot (depot is 0 thus is the following condition is always false for it)
             if(i < j) {
 
                 const auto value = + instance.get_cost(i, instance.get_depot())
                                    + instance.get_cost(instance.get_depot(), j)
-                                   - lambda * instance.get_cost(i, j);
+                                   - lambda * neighbors[n].cost;
 
                 savings.push_back({i, j, value});
 
@@ -78,6 +86,13 @@ void Solution::clarke_and_wright(float lambda, int neighbors_num) {
 
     }
 
+    this->change_tracking = tracking;
+    this->track_solution_vertices();
+
     assert(this->is_feasible());
 
 }
+
+template void BasicSolution<AbstractInstance>::clarke_and_wright(float lambda, int neighbors_num);
+template void BasicSolution<Instance>::clarke_and_wright(float lambda, int neighbors_num);
+template void BasicSolution<SubInstance>::clarke_and_wright(float lambda, int neighbors_num);
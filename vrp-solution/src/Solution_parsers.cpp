@@ -7,11 +7,18 @@
 #include <iostream>
 #include "Solution.hpp"
 #include <AbstractInstance.hpp>
+#include <Instance.hpp>
+#include <SubInstance.hpp>
 
-bool Solution::load(const std::string& path) {
+template<class InstanceType>
+bool BasicSolution<InstanceType>::load(const std::string& path) {
 
     this->reset();
 
+    // the vertices are marked once the solution has been built
+    const auto tracking = this->change_tracking;
+    this->change_tracking = false;
+
     try {
 
         std::ifstream stream(path);
@@ -40,7 +47,8 @@ bool Solution::load(const std::string& path) {
 
                     try {
 
-                        const auto customer = std::stoi(line, &sz);
+                        // files refer to the vertices with the identifiers of the instance file
+                        const auto customer = instance.get_internal_id(std::stoi(line, &sz));
 
                         if(first_customer) {
                             route = this->build_one_customer_route(customer);
@@ -69,10 +77,19 @@ bool Solution::load(const std::string& path) {
 
     } catch (std::exception &e) {
 
+        this->change_tracking = tracking;
+
         return false;
 
     }
 
+    this->change_tracking = tracking;
+    this->track_solution_vertices();
+
     return true;
 
-}
\ No newline at end of file
+}
+
+template bool BasicSolution<AbstractInstance>::load(const std::string& path);
+template bool BasicSolution<Instance>::load(const std::string& path);
+template bool BasicSolution<SubInstance>::load(const std::string& path);
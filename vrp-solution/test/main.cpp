@@ -5,9 +5,13 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <fstream>
 #include <random>
+#include <type_traits>
+#include <utility>
 #include <mm.hpp>
 #include <Instance.hpp>
+#include <SubInstance.hpp>
 #include <Solution.hpp>
 
 using testing::Eq;
@@ -32,6 +36,52 @@ namespace {
             solution.reset();
 
         }
+
+        std::mt19937 generator = std::mt19937(0);
+
+        // relocate a random customer, possibly in a new route, and return the route it lands in
+        int random_move(Solution& target) {
+            const auto customer = instance.get_customers_begin() + static_cast<int>(generator() % instance.get_customers_num());
+            const auto route = target.get_route_index(customer);
+            target.remove_vertex(route, customer);
+            if(target.is_route_empty(route)) {
+                target.remove_route(route);
+            }
+            auto where = customer;
+            while(where == customer) {
+                where = instance.get_customers_begin() + static_cast<int>(generator() % instance.get_customers_num());
+            }
+            const auto where_route = target.get_route_index(where);
+            if(generator() % 4 == 0 || target.get_route_load(where_route) + instance.get_demand(customer) > instance.get_vehicle_capacity()) {
+                return target.build_one_customer_route(customer);
+            }
+            target.insert_vertex_before(where_route, where, customer);
+            return where_route;
+        }
+
+        // random_move followed by the reversal of the destination route and the update of its cumulative loads
+        void random_move_and_reverse(Solution& target) {
+            const auto route = random_move(target);
+            if(target.get_first_customer(route) != target.get_last_customer(route)) {
+                target.reverse_route_path(route, target.get_first_customer(route), target.get_last_customer(route));
+            }
+            target.update_cumulative_route_loads(route);
+        }
+
+        static void expect_equal(Solution& a, Solution& b) {
+            ASSERT_EQ(a.get_cost(), b.get_cost());
+            ASSERT_EQ(a.get_routes_num(), b.get_routes_num());
+            auto route_b = b.get_first_route();
+            for(auto route = a.get_first_route(); route != Solution::dummy_route; route = a.get_next_route(route)) {
+                ASSERT_EQ(route, route_b);
+                ASSERT_EQ(a.to_string(route), b.to_string(route_b));
+                route_b = b.get_next_route(route_b);
+            }
+            ASSERT_EQ(std::vector<int>(a.get_unstaged_changes().begin(), a.get_unstaged_changes().end()),
+                      std::vector<int>(b.get_unstaged_changes().begin(), b.get_unstaged_changes().end()));
+            ASSERT_TRUE(a.is_feasible());
+            ASSERT_TRUE(b.is_feasible());
+        }
     };
 
     TEST_F(SolutionTest, Initialization) {
@@ -193,6 +243,304 @@ namespace {
 
     }
 
+    TEST_F(SolutionTest, Move) {
+
+        solution.clarke_and_wright();
+        const auto cost = solution.get_cost();
+        const auto routes = solution.get_routes_num();
+
+        Solution moved(std::move(solution));
+        ASSERT_EQ(moved.get_cost(), cost);
+        ASSERT_EQ(moved.get_routes_num(), routes);
+        ASSERT_TRUE(moved.is_feasible());
+
+        // move assignment exchanges the content of the two solutions
+        Solution empty(instance);
+        empty = std::move(moved);
+        ASSERT_EQ(empty.get_cost(), cost);
+        ASSERT_EQ(moved.get_routes_num(), 0);
+        ASSERT_TRUE(empty.is_feasible());
+
+        std::vector<Solution> population;
+        population.reserve(1);
+        population.push_back(empty);
+        population.push_back(std::move(empty));
+        for(auto& individual : population) {
+            ASSERT_EQ(individual.get_cost(), cost);
+            ASSERT_TRUE(individual.is_feasible());
+        }
+
+        // copy assignment reuses the destination buffers
+        moved = population.front();
+        ASSERT_EQ(moved.get_cost(), cost);
+        for(auto route = moved.get_first_route(); route != Solution::dummy_route; route = moved.get_next_route(route)) {
+            ASSERT_EQ(moved.to_string(route), population.back().to_string(route));
+        }
+
+    }
+
+    TEST_F(SolutionTest, CopyFrom) {
+
+        solution.clarke_and_wright();
+
+        Solution best(instance);
+        best.copy_from(solution);
+        ASSERT_TRUE(best.is_synchronized_with(solution));
+        ASSERT_TRUE(solution.is_synchronized_with(best));
+        ASSERT_NO_FATAL_FAILURE(expect_equal(best, solution));
+
+        for(int iter = 0; iter < 50; iter++) {
+            if(iter % 7 == 0) {
+                solution.commit();
+            }
+            for(int n = 0; n < 5; n++) {
+                random_move(solution);
+            }
+            if(iter % 3 == 0) {
+                // restore the best solution after both were modified
+                random_move(best);
+                solution.copy_from(best);
+            } else {
+                best.copy_from(solution);
+            }
+            ASSERT_NO_FATAL_FAILURE(expect_equal(best, solution));
+        }
+
+        // the routes pool must be synchronized as well
+        const auto customer = solution.get_first_customer(solution.get_first_route());
+        for(auto target : {&solution, &best}) {
+            const auto route = target->get_route_index(customer);
+            target->remove_vertex(route, customer);
+            if(target->is_route_empty(route)) {
+                target->remove_route(route);
+            }
+        }
+        ASSERT_EQ(solution.build_one_customer_route(customer), best.build_one_customer_route(customer));
+
+        // synchronizing with a third solution falls back to a full copy
+        Solution other(instance);
+        other.copy_from(solution);
+        ASSERT_FALSE(best.is_synchronized_with(solution));
+        random_move(solution);
+        best.copy_from(solution);
+        ASSERT_NO_FATAL_FAILURE(expect_equal(best, solution));
+
+        solution.reset();
+        ASSERT_FALSE(best.is_synchronized_with(solution));
+
+    }
+
+    TEST_F(SolutionTest, Transaction) {
+
+        solution.clarke_and_wright();
+        solution.commit();
+
+        Solution initial(solution);
+
+        solution.begin_transaction();
+        ASSERT_TRUE(solution.is_in_transaction());
+        for(int n = 0; n < 20; n++) {
+            random_move_and_reverse(solution);
+        }
+        ASSERT_NE(solution.get_cost(), initial.get_cost());
+        solution.rollback();
+        ASSERT_FALSE(solution.is_in_transaction());
+        ASSERT_NO_FATAL_FAILURE(expect_equal(solution, initial));
+
+        // the restored routes pool hands out the same routes
+        const auto customer = instance.get_customers_begin();
+        for(auto target : {&solution, &initial}) {
+            const auto route = target->get_route_index(customer);
+            target->remove_vertex(route, customer);
+            if(target->is_route_empty(route)) {
+                target->remove_route(route);
+            }
+        }
+        ASSERT_EQ(solution.build_one_customer_route(customer), initial.build_one_customer_route(customer));
+
+        // accepted changes are kept
+        solution.begin_transaction();
+        generator = std::mt19937(1);
+        random_move_and_reverse(solution);
+        generator = std::mt19937(1);
+        random_move_and_reverse(initial);
+        solution.commit_transaction();
+        solution.begin_transaction();
+        random_move_and_reverse(solution);
+        solution.rollback();
+        ASSERT_NO_FATAL_FAILURE(expect_equal(solution, initial));
+
+        // rollbacks are transferred by the delta copies
+        Solution best(instance);
+        best.copy_from(solution);
+        solution.begin_transaction();
+        for(int n = 0; n < 20; n++) {
+            random_move_and_reverse(solution);
+        }
+        best.copy_from(solution);
+        solution.rollback();
+        best.copy_from(solution);
+        ASSERT_NO_FATAL_FAILURE(expect_equal(best, initial));
+
+        // vertices restored after a commit within the transaction are changes again
+        solution.begin_transaction();
+        random_move_and_reverse(solution);
+        solution.commit();
+        solution.rollback();
+        ASSERT_EQ(solution.get_cost(), initial.get_cost());
+        ASSERT_FALSE(solution.get_unstaged_changes().empty());
+
+    }
+
+    TEST_F(SolutionTest, StaticDispatch) {
+
+        // Instance is final and sub-instances reach it through a typed reference, hence the cost lookups of both
+        // BasicSolution<Instance> and BasicSolution<SubInstance> are resolved at compile time
+        static_assert(std::is_final<Instance>::value, "Instance must be final");
+        static_assert(std::is_same<decltype(std::declval<const SubInstance&>().get_root()), const Instance&>::value,
+                      "SubInstance must refer to its root as an Instance");
+
+        solution.clarke_and_wright();
+
+        auto static_solution = BasicSolution<Instance>(instance);
+        static_solution.clarke_and_wright();
+
+        ASSERT_EQ(static_solution.get_cost(), solution.get_cost());
+        ASSERT_EQ(static_solution.get_routes_num(), solution.get_routes_num());
+        for(auto route = solution.get_first_route(); route != Solution::dummy_route; route = solution.get_next_route(route)) {
+            ASSERT_EQ(static_solution.to_string(route), solution.to_string(route));
+        }
+
+        auto customers = std::vector<int>();
+        for(auto i = instance.get_customers_begin(); i < instance.get_customers_end(); i += 2) {
+            customers.push_back(i);
+        }
+        auto sub_instance = SubInstance(instance, customers);
+        ASSERT_EQ(&sub_instance.get_root(), &instance);
+        auto nested_customers = std::vector<int>{1, 2, 3};
+        auto nested_instance = SubInstance(sub_instance, nested_customers);
+        ASSERT_EQ(&nested_instance.get_root(), &instance);
+
+        auto sub_solution = BasicSolution<SubInstance>(sub_instance);
+        sub_solution.clarke_and_wright();
+
+        ASSERT_EQ(sub_solution.is_feasible(), true);
+
+        auto route = sub_solution.get_first_route();
+        auto customer = sub_solution.get_first_customer(route);
+        sub_solution.remove_vertex(route, customer);
+        if(sub_solution.is_route_empty(route)) {
+            sub_solution.remove_route(route);
+            route = sub_solution.get_first_route();
+        }
+        sub_solution.insert_vertex_before(route, sub_instance.get_depot(), customer);
+
+        ASSERT_EQ(sub_solution.is_feasible(), true);
+
+    }
+
+    TEST_F(SolutionTest, RenumberedInstance) {
+
+        std::string solution_path = "X-n106-k14.sol";
+
+        solution.clarke_and_wright();
+
+        auto stream = std::ofstream(solution_path);
+        auto index = 1;
+        for(auto route = solution.get_first_route(); route != Solution::dummy_route; route = solution.get_next_route(route)) {
+            stream << "Route #" << index++ << ":";
+            for(auto customer = solution.get_first_customer(route); customer != instance.get_depot(); customer = solution.get_next_vertex(customer)) {
+                stream << " " << customer;
+            }
+            stream << "\n";
+        }
+        stream << "Cost " << solution.get_cost() << "\n";
+        stream.close();
+
+        auto options = Instance::Options();
+        options.vertices_ordering = Instance::VerticesOrdering::Hilbert;
+        auto renumbered_instance = Instance(path, options);
+
+        // routes are read and printed with the identifiers of the instance file
+        auto renumbered_solution = Solution(renumbered_instance);
+        ASSERT_TRUE(renumbered_solution.load(solution_path));
+        ASSERT_TRUE(renumbered_solution.is_feasible());
+        ASSERT_NEAR(renumbered_solution.get_cost(), solution.get_cost(), 1e-3f);
+
+        const auto get_routes = [](const Solution &current) {
+            auto routes = std::vector<std::string>();
+            for(auto route = current.get_first_route(); route != Solution::dummy_route; route = current.get_next_route(route)) {
+                const auto str = current.to_string(route);
+                routes.push_back(str.substr(str.find(']')));
+            }
+            std::sort(routes.begin(), routes.end());
+            return routes;
+        };
+
+        ASSERT_EQ(get_routes(renumbered_solution), get_routes(solution));
+
+        std::remove(solution_path.c_str());
+
+    }
+
+    TEST_F(SolutionTest, UnstagedChanges) {
+
+        solution.clarke_and_wright();
+        solution.commit();
+
+        ASSERT_TRUE(solution.get_unstaged_changes().empty());
+
+        const auto route = solution.get_first_route();
+        const auto customer = solution.get_first_customer(route);
+        const auto next = solution.get_next_vertex(customer);
+        solution.remove_vertex(route, customer);
+
+        const auto &changes = solution.get_unstaged_changes();
+        auto vertices = std::vector<int>(changes.begin(), changes.end());
+        std::sort(vertices.begin(), vertices.end());
+        auto expected = std::vector<int>({instance.get_depot(), customer, next});
+        std::sort(expected.begin(), expected.end());
+        expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+        ASSERT_EQ(vertices, expected);
+
+        solution.commit();
+        ASSERT_TRUE(solution.get_unstaged_changes().empty());
+        ASSERT_FALSE(solution.get_unstaged_changes().contains(customer));
+
+    }
+
+    TEST_F(SolutionTest, ChangeTracking) {
+
+        auto untracked_solution = Solution(instance, false);
+        untracked_solution.clarke_and_wright();
+
+        solution.clarke_and_wright();
+
+        // construction methods mark every vertex once at the end
+        ASSERT_EQ(untracked_solution.get_cost(), solution.get_cost());
+        ASSERT_TRUE(untracked_solution.get_unstaged_changes().empty());
+        ASSERT_EQ(solution.get_unstaged_changes().size(), instance.get_vertices_num());
+
+        auto route = untracked_solution.get_first_route();
+        auto customer = untracked_solution.get_first_customer(route);
+        untracked_solution.remove_vertex(route, customer);
+        untracked_solution.insert_vertex_before(route, untracked_solution.get_first_customer(route), customer);
+        ASSERT_TRUE(untracked_solution.get_unstaged_changes().empty());
+
+        untracked_solution.set_change_tracking(true);
+        ASSERT_TRUE(untracked_solution.is_tracking_changes());
+        untracked_solution.remove_vertex(route, customer);
+        ASSERT_TRUE(untracked_solution.get_unstaged_changes().contains(customer));
+
+        solution.commit();
+        solution.set_change_tracking(false);
+        route = solution.get_first_route();
+        customer = solution.get_first_customer(route);
+        solution.remove_vertex(route, customer);
+        ASSERT_TRUE(solution.get_unstaged_changes().empty());
+
+    }
+
     TEST_F(SolutionTest, DepotMovement) {
 
         solution.clarke_and_wright();